@@ -0,0 +1,165 @@
+/**
+ * IT8951 driver benchmark suite
+ *
+ * Exercises full-frame and partial displays across waveform modes, clear
+ * operations, and the chunk-size sweep, reporting MB/s and latency
+ * percentiles so driver changes can be compared across releases.
+ *
+ * Build: make bench
+ * Run:   sudo ./bench /dev/sda [iterations]
+ */
+
+#include "it8951_usb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_ITERS 10
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double d = *(const double *)a - *(const double *)b;
+    return (d > 0) - (d < 0);
+}
+
+static double percentile(double *sorted, int n, double p) {
+    int idx = (int)(p * (n - 1) + 0.5);
+    return sorted[idx];
+}
+
+static void report(const char *name, double *samples, int n, double mb_per_op) {
+    qsort(samples, n, sizeof(double), cmp_double);
+    double p50 = percentile(samples, n, 0.50);
+    double p90 = percentile(samples, n, 0.90);
+    double p99 = percentile(samples, n, 0.99);
+    printf("%-28s p50=%7.1f ms  p90=%7.1f ms  p99=%7.1f ms",
+           name, p50, p90, p99);
+    if (mb_per_op > 0) {
+        printf("  %6.1f MB/s", mb_per_op / (p50 / 1000.0));
+    }
+    printf("\n");
+}
+
+// Gradient test pattern: exercises all gray levels
+static void fill_gradient(uint8_t *buf, int w, int h, int phase) {
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            buf[(size_t)y * w + x] = (uint8_t)((x + y + phase) & 0xFF);
+        }
+    }
+}
+
+static void bench_mode(IT8951_USB *dev, const char *name, int mode,
+                       uint8_t *frame, int iters, double *samples) {
+    int w = dev->width, h = dev->height;
+    for (int i = 0; i < iters; i++) {
+        fill_gradient(frame, w, h, i * 37);
+        double t0 = now_ms();
+        it8951_display(dev, frame, 0, 0, w, h, mode);
+        samples[i] = now_ms() - t0;
+    }
+    report(name, samples, iters, (double)w * h / 1e6);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("Usage: sudo %s /dev/sdX [iterations]\n", argv[0]);
+        return 1;
+    }
+    int iters = (argc > 2) ? atoi(argv[2]) : DEFAULT_ITERS;
+    if (iters < 1) iters = DEFAULT_ITERS;
+
+    IT8951_USB *dev = it8951_usb_open(argv[1]);
+    if (!dev) return 1;
+
+    int w = dev->width, h = dev->height;
+    uint8_t *frame = malloc((size_t)w * h);
+    double *samples = malloc(iters * sizeof(double));
+    if (!frame || !samples) {
+        it8951_usb_close(dev);
+        return 1;
+    }
+
+    printf("Benchmarking %dx%d, %d iterations per test\n\n", w, h, iters);
+    it8951_clear(dev, MODE_INIT);
+    it8951_reset_stats(dev);
+
+    // Full-frame displays per waveform mode
+    bench_mode(dev, "full-frame DU", MODE_DU, frame, iters, samples);
+    bench_mode(dev, "full-frame GC16", MODE_GC16, frame, iters, samples);
+    bench_mode(dev, "full-frame A2", MODE_A2, frame, iters, samples);
+
+    // Partial displays: full-width strip vs narrow column
+    int sh = h / 8;
+    for (int i = 0; i < iters; i++) {
+        fill_gradient(frame, w, sh, i * 37);
+        double t0 = now_ms();
+        it8951_display(dev, frame, 0, (i * sh) % (h - sh), w, sh, MODE_A2);
+        samples[i] = now_ms() - t0;
+    }
+    report("partial strip A2 (h/8)", samples, iters, (double)w * sh / 1e6);
+
+    int cw = 104;  // Narrow status column
+    for (int i = 0; i < iters; i++) {
+        fill_gradient(frame, cw, h, i * 37);
+        double t0 = now_ms();
+        it8951_display(dev, frame, (i * cw) % (w - cw), 0, cw, h, MODE_A2);
+        samples[i] = now_ms() - t0;
+    }
+    report("partial column A2 (104px)", samples, iters, (double)cw * h / 1e6);
+
+    // Clear
+    for (int i = 0; i < iters; i++) {
+        double t0 = now_ms();
+        it8951_clear(dev, MODE_INIT);
+        samples[i] = now_ms() - t0;
+    }
+    report("clear INIT", samples, iters, 0);
+
+    // Chunk-size sweep: upload cost only (A2 keeps the refresh cheap)
+    printf("\nChunk-size sweep (full-frame A2):\n");
+    static const int chunk_sizes[] = { 8192, 16384, 32768, 60800 };
+    for (unsigned int c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+        it8951_set_chunk_size(dev, chunk_sizes[c]);
+        char label[32];
+        snprintf(label, sizeof(label), "  chunk %d", chunk_sizes[c]);
+        bench_mode(dev, label, MODE_A2, frame, iters, samples);
+    }
+    it8951_set_chunk_size(dev, 60800);
+
+    // Autotuner: raw upload curve and what the driver would adopt
+    printf("\nAutotune:\n");
+    IT8951_tune_point pts[8];
+    int adopted = it8951_calibrate(dev, pts, 8);
+    for (int i = 0; i < 8 && pts[i].chunk_size; i++) {
+        printf("  chunk %5d: %6.2f MB/s\n", pts[i].chunk_size, pts[i].mb_per_s);
+    }
+    if (adopted > 0) {
+        printf("  adopted chunk %d, timeout %d ms\n", adopted, dev->timeout_ms);
+    } else {
+        printf("  calibration failed\n");
+    }
+
+    // Driver counters over the whole run
+    IT8951_stats st;
+    it8951_get_stats(dev, &st);
+    printf("\nDriver stats: %llu SG_IO calls, %.1f MB sent, "
+           "load %.1f ms, refresh %.1f ms, %llu refreshes, "
+           "%llu retries, %llu reopens\n",
+           (unsigned long long)st.sgio_calls, st.bytes_sent / 1e6,
+           st.load_ns / 1e6, st.display_ns / 1e6,
+           (unsigned long long)st.refreshes,
+           (unsigned long long)st.retries,
+           (unsigned long long)st.reopens);
+
+    free(frame);
+    free(samples);
+    it8951_usb_close(dev);
+    return 0;
+}
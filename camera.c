@@ -7,6 +7,15 @@
  */
 
 #include "it8951_usb.h"
+#include "capture.h"
+#include "imgproc.h"
+#include "workers.h"
+#include "er8.h"
+#include "daemon.h"
+#include "netrecv.h"
+#include "geom.h"
+#include "input.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,8 +24,10 @@
 #include <time.h>
 #include <sys/time.h>
 
-#define DISPLAY_WIDTH  1872
-#define DISPLAY_HEIGHT 1404
+// Panel geometry comes from the build (make GEOM=portrait for the
+// 1404x1872 variant) so the app and the specialized kernels agree
+#define DISPLAY_WIDTH  EINK_GEOM_WIDTH
+#define DISPLAY_HEIGHT EINK_GEOM_HEIGHT
 
 // Get time in milliseconds
 static double get_time_ms() {
@@ -83,6 +94,78 @@ static uint8_t* generate_countdown_image(int digit) {
     return buf;
 }
 
+// Seven-segment digit rendering: native fallback when ImageMagick is
+// not installed. Segment order: top, top-left, top-right, middle,
+// bottom-left, bottom-right, bottom
+static const uint8_t seg_table[10] = {
+    0x77, 0x24, 0x5D, 0x6D,  // 0 1 2 3
+    0x2E, 0x6B, 0x7B, 0x25,  // 4 5 6 7
+    0x7F, 0x6F               // 8 9
+};
+
+static void fill_rect(uint8_t *buf, int x, int y, int w, int h) {
+    for (int row = y; row < y + h; row++) {
+        memset(buf + (size_t)row * DISPLAY_WIDTH + x, 0x00, w);
+    }
+}
+
+static void render_countdown_native(uint8_t *buf, int digit) {
+    int size = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+    memset(buf, 0xFF, size);  // White
+
+    // Circle outline, radius 400, stroke 20
+    int cx = DISPLAY_WIDTH / 2;
+    int cy = DISPLAY_HEIGHT / 2;
+    int r_out = 400 + 10, r_in = 400 - 10;
+    for (int y = cy - r_out; y <= cy + r_out; y++) {
+        for (int x = cx - r_out; x <= cx + r_out; x++) {
+            int dx = x - cx, dy = y - cy;
+            int d2 = dx * dx + dy * dy;
+            if (d2 <= r_out * r_out && d2 >= r_in * r_in) {
+                buf[(size_t)y * DISPLAY_WIDTH + x] = 0x00;
+            }
+        }
+    }
+
+    // Seven-segment digit inside the circle: 280 wide, 480 tall, 50 thick
+    int dw = 280, dh = 480, t = 50;
+    int x0 = cx - dw / 2, y0 = cy - dh / 2;
+    uint8_t segs = seg_table[digit];
+    if (segs & 0x01) fill_rect(buf, x0, y0, dw, t);                            // top
+    if (segs & 0x02) fill_rect(buf, x0, y0, t, dh / 2);                        // top-left
+    if (segs & 0x04) fill_rect(buf, x0 + dw - t, y0, t, dh / 2);               // top-right
+    if (segs & 0x08) fill_rect(buf, x0, y0 + dh / 2 - t / 2, dw, t);           // middle
+    if (segs & 0x10) fill_rect(buf, x0, y0 + dh / 2, t, dh / 2);               // bottom-left
+    if (segs & 0x20) fill_rect(buf, x0 + dw - t, y0 + dh / 2, t, dh / 2);      // bottom-right
+    if (segs & 0x40) fill_rect(buf, x0, y0 + dh - t, dw, t);                   // bottom
+}
+
+// Resident cache of prerendered countdown frames, keyed by digit.
+// Rendering (ImageMagick fork + 2.6 MB /tmp read) happens once per digit;
+// after that each countdown step is a pure it8951_display() call
+static uint8_t *countdown_cache[10];
+
+static uint8_t* get_countdown_frame(int digit) {
+    if (digit < 0 || digit > 9) return NULL;
+    if (countdown_cache[digit]) return countdown_cache[digit];
+
+    uint8_t *buf = generate_countdown_image(digit);
+    if (!buf) {
+        // No ImageMagick: rasterize natively
+        buf = malloc(DISPLAY_WIDTH * DISPLAY_HEIGHT);
+        if (!buf) return NULL;
+        render_countdown_native(buf, digit);
+    }
+    countdown_cache[digit] = buf;
+    return buf;
+}
+
+static void prerender_countdown_frames(void) {
+    for (int i = 3; i >= 1; i--) {
+        get_countdown_frame(i);
+    }
+}
+
 // Capture photo using libcamera-still
 static int capture_photo(const char *filename) {
     char cmd[512];
@@ -92,133 +175,275 @@ static int capture_photo(const char *filename) {
     return system(cmd);
 }
 
-// Load JPEG and convert to 8-bit grayscale raw
+// Load JPEG and convert to 8-bit grayscale raw (native decode, no fork)
 static uint8_t* load_jpeg_as_gray(const char *filename, int *width, int *height) {
-    char cmd[512];
-    char tmpfile[] = "/tmp/eink_gray.raw";
-
-    // Use ImageMagick to convert
-    snprintf(cmd, sizeof(cmd),
-        "convert %s -resize %dx%d! -colorspace Gray -depth 8 gray:%s",
-        filename, DISPLAY_WIDTH, DISPLAY_HEIGHT, tmpfile);
-
-    if (system(cmd) != 0) {
-        return NULL;
-    }
-
-    // Read raw file
-    FILE *f = fopen(tmpfile, "rb");
-    if (!f) return NULL;
-
-    int size = DISPLAY_WIDTH * DISPLAY_HEIGHT;
-    uint8_t *buf = malloc(size);
-    if (!buf) {
-        fclose(f);
-        return NULL;
-    }
-
-    fread(buf, 1, size, f);
-    fclose(f);
+    uint8_t *buf = imgproc_load_jpeg_gray(filename, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    if (!buf) return NULL;
 
     *width = DISPLAY_WIDTH;
     *height = DISPLAY_HEIGHT;
     return buf;
 }
 
+// Capture one frame via the forked libcamera-still/convert fallback path
+static int capture_frame_fallback(uint8_t *buf) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd),
+        "libcamera-still -o /tmp/frame.jpg --width %d --height %d "
+        "-t 1 --nopreview --immediate 2>/dev/null",
+        DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    if (system(cmd) != 0) return -1;
+
+    uint8_t *gray = imgproc_load_jpeg_gray("/tmp/frame.jpg",
+                                           DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    if (!gray) return -1;
+    memcpy(buf, gray, DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    free(gray);
+    return 0;
+}
+
+// Change gate for streaming: skip the display entirely when no tile of
+// the incoming frame moved more than this mean-abs-diff past the last
+// displayed frame. Sensor noise on a static scene scores ~2-4 counts.
+#define STREAM_GATE_THRESHOLD 6
+
 // Video streaming mode - continuous capture and display
 static void do_stream(IT8951_USB *dev) {
     printf("Streaming mode (press any key to stop)...\n");
 
+    // Keep the camera streaming in-process; fall back to forking
+    // libcamera-still per frame if no V4L2 capture device is available
+    CaptureDev *cap = capture_open("/dev/video0", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    if (!cap) {
+        printf("No V4L2 capture device, falling back to libcamera-still\n");
+    }
+
+    uint8_t *buf = malloc(DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    uint8_t *last = malloc(DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    if (!buf || !last) {
+        free(buf);
+        free(last);
+        if (cap) capture_close(cap);
+        return;
+    }
+
     int frame = 0;
+    int skipped = 0;
+    int have_last = 0;
     double start_time = get_time_ms();
 
     while (1) {
-        // Check for keypress to stop
-        char c;
-        if (read(STDIN_FILENO, &c, 1) == 1) {
+        // Any key or button press stops the stream
+        InputEvent ev;
+        if (input_next(&ev, 0)) {
             printf("\nStopping stream...\n");
             break;
         }
 
         double t0 = get_time_ms();
 
-        // Capture frame using libcamera-still (fast mode)
-        char cmd[512];
-        snprintf(cmd, sizeof(cmd),
-            "libcamera-still -o /tmp/frame.jpg --width %d --height %d "
-            "-t 1 --nopreview --immediate 2>/dev/null",
-            DISPLAY_WIDTH, DISPLAY_HEIGHT);
-        system(cmd);
-
-        // Convert to grayscale
-        snprintf(cmd, sizeof(cmd),
-            "convert /tmp/frame.jpg -colorspace Gray -depth 8 gray:/tmp/frame.raw");
-        system(cmd);
-
-        // Read and display
-        FILE *f = fopen("/tmp/frame.raw", "rb");
-        if (f) {
-            int size = DISPLAY_WIDTH * DISPLAY_HEIGHT;
-            uint8_t *buf = malloc(size);
-            if (buf) {
-                fread(buf, 1, size, f);
-                it8951_display(dev, buf, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, MODE_A2);
-                free(buf);
+        int ok;
+        trace_begin("cam_frame");
+        if (cap) {
+            ok = capture_frame(cap, buf, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        } else {
+            ok = capture_frame_fallback(buf);
+        }
+        trace_end("cam_frame");
+
+        if (ok == 0) {
+            // Static scene: don't touch the bus or the panel at all.
+            // The exact-diff engine below would still fire on sensor
+            // noise; the tile gate absorbs it.
+            if (have_last &&
+                imgproc_frame_change(buf, last, DISPLAY_WIDTH, DISPLAY_HEIGHT)
+                    <= STREAM_GATE_THRESHOLD) {
+                skipped++;
+            } else {
+                // Only push the regions that changed since the last frame
+                it8951_display_diff(dev, buf, MODE_A2);
+                memcpy(last, buf, DISPLAY_WIDTH * DISPLAY_HEIGHT);
+                have_last = 1;
             }
-            fclose(f);
         }
 
         frame++;
         double elapsed = get_time_ms() - start_time;
         double fps = frame / (elapsed / 1000.0);
-        printf("\rFrame %d (%.1f fps, %.0f ms/frame)", frame, fps, get_time_ms() - t0);
+        printf("\rFrame %d (%.1f fps, %.0f ms/frame, %d skipped)",
+               frame, fps, get_time_ms() - t0, skipped);
         fflush(stdout);
     }
 
     double total = get_time_ms() - start_time;
-    printf("\nStreamed %d frames in %.1f sec (%.2f fps avg)\n",
-           frame, total/1000.0, frame/(total/1000.0));
+    printf("\nStreamed %d frames in %.1f sec (%.2f fps avg, %d skipped static)\n",
+           frame, total/1000.0, frame/(total/1000.0), skipped);
+
+    free(buf);
+    free(last);
+    if (cap) capture_close(cap);
 }
 
-// Do countdown and capture
+// Band callback for the streaming decode: each decoded band is pushed
+// straight to the device, so peak memory is one band, not one frame
+static void upload_band(const uint8_t *rows, int y, int h, void *ctx) {
+    IT8951_USB *dev = ctx;
+    it8951_upload(dev, (uint8_t *)rows, 0, y, DISPLAY_WIDTH, h);
+}
+
+// Pipeline stage: camera capture on its own thread, so libcamera-still's
+// ~1s startup + exposure overlaps the final countdown refresh
+static void *capture_stage(void *arg) {
+    int *ret = arg;
+    trace_begin("capture");
+    *ret = capture_photo("/tmp/capture.jpg");
+    trace_end("capture");
+    return NULL;
+}
+
+// Display the captured photo without holding a decoded frame in memory:
+// decode in bands straight onto the bus, one GC16 refresh at the end.
+// Only works when the decoded size lands exactly on the panel.
+static int display_photo_streamed(IT8951_USB *dev) {
+    int band_rows = dev->chunk_size / DISPLAY_WIDTH;
+    if (imgproc_stream_jpeg_gray("/tmp/capture.jpg",
+                                 DISPLAY_WIDTH, DISPLAY_HEIGHT,
+                                 band_rows, upload_band, dev) != 0) {
+        return -1;
+    }
+    return it8951_refresh(dev, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, MODE_AUTO);
+}
+
+// Countdown and capture, overlapped where it doesn't cost memory: the
+// camera starts while the final countdown digit refreshes. The display
+// side stays on the band-streamed decode so the photo never exists as a
+// full frame on our side (the small-Pi constraint); the shutter flash
+// runs before it because streaming needs the device.
 static void do_capture(IT8951_USB *dev) {
     printf("Countdown...\n");
 
-    // 3-2-1 countdown
+    pthread_t cap_thread;
+    int cap_ret = -1;
+    int cap_started = 0;
+
+    // 3-2-1 countdown from the prerendered frame cache
     for (int i = 3; i >= 1; i--) {
         printf("%d...\n", i);
-        uint8_t *buf = generate_countdown_image(i);
+        if (i == 1) {
+            // Kick the camera now; it warms up during the refresh below
+            cap_started = (pthread_create(&cap_thread, NULL,
+                                          capture_stage, &cap_ret) == 0);
+        }
+        uint8_t *buf = get_countdown_frame(i);
         if (buf) {
             it8951_display(dev, buf, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, MODE_A2);
-            free(buf);
         }
         if (i > 1) usleep(800000);  // 800ms between digits
     }
 
     printf("CAPTURE!\n");
 
-    // Capture photo
     double t0 = get_time_ms();
-    capture_photo("/tmp/capture.jpg");
-    printf("Capture: %.0f ms\n", get_time_ms() - t0);
+    if (cap_started) {
+        pthread_join(cap_thread, NULL);
+    } else {
+        cap_ret = capture_photo("/tmp/capture.jpg");
+    }
+    printf("Capture: %.0f ms after countdown\n", get_time_ms() - t0);
+    if (cap_ret != 0) {
+        printf("Capture failed\n");
+        return;
+    }
 
-    // Load and display
+    // Shutter feedback, then decode in bands straight onto the bus: the
+    // streamed path caps peak memory at one band instead of a 2.6 MB
+    // frame, which matters more on the small-Pi units than the few
+    // hundred ms an overlapped flash would save
+    t0 = get_time_ms();
+    it8951_clear(dev, MODE_DU);
+    if (display_photo_streamed(dev) == 0) {
+        printf("Display: %.0f ms (streamed)\n", get_time_ms() - t0);
+        return;
+    }
+
+    // Streaming needs the decoded size to land exactly on the panel;
+    // otherwise materialize the frame and resize
     int w, h;
+    trace_begin("decode");
     uint8_t *photo = load_jpeg_as_gray("/tmp/capture.jpg", &w, &h);
+    trace_end("decode");
     if (photo) {
-        t0 = get_time_ms();
-        it8951_display(dev, photo, 0, 0, w, h, MODE_GC16);
+        // AUTO: documents and QR codes refresh with fast DU,
+        // photos with real midtones still get GC16
+        it8951_display(dev, photo, 0, 0, w, h, MODE_AUTO);
         printf("Display: %.0f ms\n", get_time_ms() - t0);
         free(photo);
-    } else {
-        printf("Failed to load photo\n");
+        return;
     }
+    printf("Failed to load photo\n");
+}
+
+// Display a prepared .er8 file: the mmap'd payload goes straight into the
+// USB transfer path with no decode and no intermediate buffer
+static int show_er8(IT8951_USB *dev, const char *path) {
+    ER8File *f = er8_open(path);
+    if (!f) {
+        printf("Failed to open %s\n", path);
+        return -1;
+    }
+
+    // er8_open() only checks the file against itself; a frame larger
+    // than the panel would run the driver's shadow copy out of bounds
+    if (f->width > dev->width || f->height > dev->height) {
+        printf("%s: %dx%d exceeds the %dx%d panel\n",
+               path, f->width, f->height, dev->width, dev->height);
+        er8_close(f);
+        return -1;
+    }
+
+    double t0 = get_time_ms();
+    int ret = it8951_display(dev, f->pixels, 0, 0, f->width, f->height, MODE_GC16);
+    printf("%s: %dx%d displayed in %.0f ms\n",
+           path, f->width, f->height, get_time_ms() - t0);
+
+    er8_close(f);
+    return ret;
+}
+
+// Submit .er8 files to a running daemon instead of opening the device
+static int send_to_daemon(int argc, char **argv) {
+    EinkClient *client = NULL;
+    for (int i = 2; i < argc; i++) {
+        ER8File *f = er8_open(argv[i]);
+        if (!f) {
+            printf("Failed to open %s\n", argv[i]);
+            continue;
+        }
+        if (!client) {
+            client = eink_client_connect(f->width, f->height);
+            if (!client) {
+                printf("No daemon at %s (start with --daemon)\n", EINK_SOCKET_PATH);
+                er8_close(f);
+                return 1;
+            }
+        }
+        int ret = eink_client_display(client, f->pixels, 0, 0,
+                                      f->width, f->height, MODE_GC16);
+        printf("%s: %s\n", argv[i], ret == 0 ? "displayed" : "failed");
+        er8_close(f);
+    }
+    if (client) eink_client_close(client);
+    return 0;
 }
 
 int main(int argc, char **argv) {
     if (argc < 2) {
         printf("E-Ink Camera\n");
-        printf("Usage: sudo %s /dev/sdX\n", argv[0]);
+        printf("Usage: sudo %s /dev/sdX [image.er8 ...]\n", argv[0]);
+        printf("       sudo %s --daemon /dev/sdX   (hold device open, serve frames)\n", argv[0]);
+        printf("       %s --send image.er8 ...     (submit frames to the daemon)\n", argv[0]);
+        printf("       sudo %s --net /dev/sdX [port]  (display frames streamed over TCP)\n", argv[0]);
+        printf("  With .er8 files: display them and exit (slideshow)\n");
         printf("  Press '1' to capture with countdown\n");
         printf("  Press '2' to start video streaming\n");
         printf("  Press 'c' to clear display\n");
@@ -226,21 +451,83 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    // Client mode: talk to a running daemon, no device access needed
+    if (strcmp(argv[1], "--send") == 0) {
+        return send_to_daemon(argc, argv);
+    }
+
+    // Daemon mode: keep the device warm and serve frames over IPC
+    if (strcmp(argv[1], "--daemon") == 0) {
+        if (argc < 3) {
+            printf("Usage: sudo %s --daemon /dev/sdX\n", argv[0]);
+            return 1;
+        }
+        IT8951_USB *ddev = it8951_usb_open(argv[2]);
+        if (!ddev) return 1;
+        workers_init(0);
+        int ret = eink_daemon_run(ddev);
+        it8951_usb_close(ddev);
+        return ret == 0 ? 0 : 1;
+    }
+
+    // Network mode: remote renderer pushes frames, we only scan out
+    if (strcmp(argv[1], "--net") == 0) {
+        if (argc < 3) {
+            printf("Usage: sudo %s --net /dev/sdX [port]\n", argv[0]);
+            return 1;
+        }
+        IT8951_USB *ndev = it8951_usb_open(argv[2]);
+        if (!ndev) return 1;
+        workers_init(0);
+        int ret = eink_net_run(ndev, argc > 3 ? atoi(argv[3]) : 0);
+        it8951_usb_close(ndev);
+        return ret == 0 ? 0 : 1;
+    }
+
     IT8951_USB *dev = it8951_usb_open(argv[1]);
     if (!dev) {
         printf("Failed to open %s\n", argv[1]);
         return 1;
     }
 
+    // Slideshow mode: display prepared raw frames and exit
+    if (argc > 2) {
+        for (int i = 2; i < argc; i++) {
+            show_er8(dev, argv[i]);
+            if (i + 1 < argc) sleep(5);
+        }
+        it8951_usb_close(dev);
+        return 0;
+    }
+
+    // Spread pixel kernels (resize, future dither/pack) across cores
+    workers_init(0);
+
+    // Render the countdown digits once up front so the 3-2-1 cadence
+    // doesn't stutter on first use
+    prerender_countdown_frames();
+
     printf("E-Ink Camera ready!\n");
     printf("Display: %dx%d\n", dev->width, dev->height);
-    printf("Press '1' to capture, '2' to stream, 'c' to clear, 'q' to quit\n\n");
+    printf("Press '1' to capture, '2' to stream, 'c' to clear, "
+           "'t' to dump a trace, 'q' to quit\n\n");
 
     enable_raw_mode();
+    trace_install_signal();
+    if (input_start() != 0) {
+        printf("Failed to start input thread\n");
+        it8951_usb_close(dev);
+        return 1;
+    }
 
-    char c;
+    // Button maps onto the same actions as the keys: short press
+    // captures, holding past the threshold enters streaming (the
+    // nearest thing this app has to the Python app's mode cycling)
+    InputEvent ev;
     while (1) {
-        if (read(STDIN_FILENO, &c, 1) == 1) {
+        if (input_next(&ev, 500)) {
+            char c = (ev.type == INPUT_KEY) ? ev.ch
+                   : (ev.type == INPUT_PRESS) ? '1' : '2';
             if (c == 'q' || c == 'Q') {
                 printf("\nQuitting...\n");
                 break;
@@ -254,10 +541,21 @@ int main(int argc, char **argv) {
                 printf("Clearing display...\n");
                 it8951_clear(dev, MODE_INIT);
                 printf("Done\n");
+            } else if (c == 't' || c == 'T') {
+                if (trace_dump(TRACE_DUMP_PATH) == 0) {
+                    printf("Trace dumped to %s\n", TRACE_DUMP_PATH);
+                }
             }
+        } else {
+            // Idle: dump a signal-requested trace, then let the scheduler
+            // reconcile ghosted tiles with GC16
+            trace_poll();
+            it8951_maintain(dev);
         }
     }
 
+    input_stop();
+    workers_shutdown();
     it8951_usb_close(dev);
     return 0;
 }
@@ -0,0 +1,169 @@
+/**
+ * In-process camera capture via V4L2 mmap'd buffer queue
+ *
+ * The streaming loop used to fork libcamera-still per frame, paying process
+ * spawn + pipeline init + JPEG round trip (600-900 ms) every iteration.
+ * Keeping the camera streaming and handing raw frames out directly turns
+ * that into a single DQBUF.
+ */
+
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <linux/videodev2.h>
+
+static int xioctl(int fd, unsigned long req, void *arg) {
+    int r;
+    do {
+        r = ioctl(fd, req, arg);
+    } while (r < 0 && errno == EINTR);
+    return r;
+}
+
+CaptureDev* capture_open(const char *device, int width, int height) {
+    CaptureDev *cap = calloc(1, sizeof(CaptureDev));
+    if (!cap) return NULL;
+
+    cap->fd = open(device, O_RDWR | O_NONBLOCK);
+    if (cap->fd < 0) {
+        free(cap);
+        return NULL;
+    }
+
+    struct v4l2_capability caps;
+    if (xioctl(cap->fd, VIDIOC_QUERYCAP, &caps) < 0 ||
+        !(caps.capabilities & V4L2_CAP_VIDEO_CAPTURE) ||
+        !(caps.capabilities & V4L2_CAP_STREAMING)) {
+        close(cap->fd);
+        free(cap);
+        return NULL;
+    }
+
+    // Ask for YUYV so the Y plane gives us grayscale for free; take
+    // whatever geometry the driver actually grants
+    struct v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(cap->fd, VIDIOC_S_FMT, &fmt) < 0) {
+        close(cap->fd);
+        free(cap);
+        return NULL;
+    }
+    cap->width = fmt.fmt.pix.width;
+    cap->height = fmt.fmt.pix.height;
+    cap->pixelformat = fmt.fmt.pix.pixelformat;
+
+    // mmap'd buffer queue
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = CAPTURE_NUM_BUFFERS;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(cap->fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        close(cap->fd);
+        free(cap);
+        return NULL;
+    }
+    cap->num_buffers = req.count;
+
+    for (int i = 0; i < cap->num_buffers; i++) {
+        struct v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(cap->fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            capture_close(cap);
+            return NULL;
+        }
+        cap->buffer_lengths[i] = buf.length;
+        cap->buffers[i] = mmap(NULL, buf.length, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, cap->fd, buf.m.offset);
+        if (cap->buffers[i] == MAP_FAILED) {
+            cap->buffers[i] = NULL;
+            capture_close(cap);
+            return NULL;
+        }
+        if (xioctl(cap->fd, VIDIOC_QBUF, &buf) < 0) {
+            capture_close(cap);
+            return NULL;
+        }
+    }
+
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(cap->fd, VIDIOC_STREAMON, &type) < 0) {
+        capture_close(cap);
+        return NULL;
+    }
+    cap->streaming = 1;
+
+    printf("Capture: %s %dx%d (%c%c%c%c)\n", device, cap->width, cap->height,
+           cap->pixelformat & 0xff, (cap->pixelformat >> 8) & 0xff,
+           (cap->pixelformat >> 16) & 0xff, (cap->pixelformat >> 24) & 0xff);
+    return cap;
+}
+
+void capture_close(CaptureDev *cap) {
+    if (!cap) return;
+    if (cap->streaming) {
+        enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(cap->fd, VIDIOC_STREAMOFF, &type);
+    }
+    for (int i = 0; i < cap->num_buffers; i++) {
+        if (cap->buffers[i]) munmap(cap->buffers[i], cap->buffer_lengths[i]);
+    }
+    close(cap->fd);
+    free(cap);
+}
+
+// Extract luma from the captured frame and nearest-neighbor scale to w x h
+static void frame_to_gray(CaptureDev *cap, const uint8_t *src,
+                          uint8_t *gray, int w, int h) {
+    int sw = cap->width;
+    int sh = cap->height;
+    // YUYV: Y at every even byte; GREY: 1 byte per pixel
+    int step = (cap->pixelformat == V4L2_PIX_FMT_GREY) ? 1 : 2;
+
+    for (int y = 0; y < h; y++) {
+        int sy = y * sh / h;
+        const uint8_t *src_row = src + (size_t)sy * sw * step;
+        uint8_t *dst_row = gray + (size_t)y * w;
+        for (int x = 0; x < w; x++) {
+            dst_row[x] = src_row[(x * sw / w) * step];
+        }
+    }
+}
+
+int capture_frame(CaptureDev *cap, uint8_t *gray, int w, int h) {
+    // Wait for a filled buffer
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(cap->fd, &fds);
+    struct timeval tv = { .tv_sec = 2, .tv_usec = 0 };
+    if (select(cap->fd + 1, &fds, NULL, NULL, &tv) <= 0) {
+        return -1;
+    }
+
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(cap->fd, VIDIOC_DQBUF, &buf) < 0) {
+        return -1;
+    }
+
+    frame_to_gray(cap, cap->buffers[buf.index], gray, w, h);
+
+    return xioctl(cap->fd, VIDIOC_QBUF, &buf);
+}
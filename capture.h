@@ -0,0 +1,36 @@
+/**
+ * In-process camera capture via V4L2
+ * Keeps the camera streaming between frames instead of forking
+ * libcamera-still per capture
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+
+#define CAPTURE_NUM_BUFFERS 4
+
+typedef struct {
+    int fd;
+    int width;        // Format actually negotiated with the driver
+    int height;
+    int pixelformat;  // V4L2 fourcc
+    void *buffers[CAPTURE_NUM_BUFFERS];
+    unsigned int buffer_lengths[CAPTURE_NUM_BUFFERS];
+    int num_buffers;
+    int streaming;
+} CaptureDev;
+
+// Open a V4L2 capture device and start streaming. Requests YUYV at the
+// given size; the driver may negotiate a different geometry.
+CaptureDev* capture_open(const char *device, int width, int height);
+
+// Stop streaming and release the mmap'd buffer queue
+void capture_close(CaptureDev *cap);
+
+// Dequeue the next frame, convert to 8-bit grayscale scaled to w x h,
+// and requeue the buffer. Returns 0 on success.
+int capture_frame(CaptureDev *cap, uint8_t *gray, int w, int h);
+
+#endif
@@ -0,0 +1,293 @@
+/**
+ * Daemon mode - see daemon.h
+ */
+
+#define _GNU_SOURCE
+#include "daemon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+
+#define MAX_CLIENTS 8
+
+// Per-connection state: the client's mapped ring
+typedef struct {
+    int fd;              // Socket (-1 = free)
+    uint8_t *shm;
+    size_t shm_len;
+    size_t slot_size;
+    int slots;
+    int width, height;
+} Conn;
+
+// Receive a struct plus an optional SCM_RIGHTS fd
+static int recv_msg(int sock, void *buf, size_t len, int *fd_out) {
+    struct iovec iov = { buf, len };
+    union {
+        struct cmsghdr hdr;
+        char data[CMSG_SPACE(sizeof(int))];
+    } cmsg;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = &cmsg;
+    msg.msg_controllen = sizeof(cmsg);
+
+    ssize_t n = recvmsg(sock, &msg, 0);
+    if (n != (ssize_t)len) return -1;
+
+    if (fd_out) {
+        *fd_out = -1;
+        struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+        if (c && c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+            memcpy(fd_out, CMSG_DATA(c), sizeof(int));
+        }
+    }
+    return 0;
+}
+
+// Send a struct with an optional fd attached
+static int send_msg(int sock, const void *buf, size_t len, int fd) {
+    struct iovec iov = { (void *)buf, len };
+    union {
+        struct cmsghdr hdr;
+        char data[CMSG_SPACE(sizeof(int))];
+    } cmsg;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd >= 0) {
+        memset(&cmsg, 0, sizeof(cmsg));
+        msg.msg_control = &cmsg;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int));
+        struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &fd, sizeof(int));
+    }
+    return (sendmsg(sock, &msg, 0) == (ssize_t)len) ? 0 : -1;
+}
+
+static void conn_close(Conn *conn) {
+    if (conn->shm) munmap(conn->shm, conn->shm_len);
+    if (conn->fd >= 0) close(conn->fd);
+    conn->fd = -1;
+    conn->shm = NULL;
+}
+
+// Hello: map the client's ring memfd
+static int conn_setup(Conn *conn) {
+    EinkHello hello;
+    int memfd = -1;
+    if (recv_msg(conn->fd, &hello, sizeof(hello), &memfd) < 0 ||
+        hello.magic != EINK_HELLO_MAGIC || memfd < 0 ||
+        hello.slots < 1 || hello.slots > 8 ||
+        hello.width == 0 || hello.width > 4096 ||
+        hello.height == 0 || hello.height > 4096) {
+        if (memfd >= 0) close(memfd);
+        return -1;
+    }
+
+    conn->width = hello.width;
+    conn->height = hello.height;
+    conn->slots = hello.slots;
+    conn->slot_size = (size_t)hello.width * hello.height;
+    conn->shm_len = conn->slot_size * hello.slots;
+
+    // Mapping past the memfd's EOF succeeds and SIGBUSes on first touch,
+    // so a short or later-shrunk ring would take the daemon down. Require
+    // the fd to actually back the declared ring and to be sealed against
+    // shrinking - the client seals it right after ftruncate.
+    struct stat st;
+    int seals = fcntl(memfd, F_GET_SEALS);
+    if (fstat(memfd, &st) < 0 || st.st_size < 0 ||
+        (size_t)st.st_size < conn->shm_len ||
+        seals < 0 || !(seals & F_SEAL_SHRINK)) {
+        close(memfd);
+        return -1;
+    }
+
+    conn->shm = mmap(NULL, conn->shm_len, PROT_READ, MAP_SHARED, memfd, 0);
+    close(memfd);
+    return (conn->shm == MAP_FAILED) ? (conn->shm = NULL, -1) : 0;
+}
+
+// One frame command: display straight out of shared memory (zero copy)
+static int conn_frame(Conn *conn, IT8951_USB *dev) {
+    EinkFrameMsg m;
+    if (recv_msg(conn->fd, &m, sizeof(m), NULL) < 0) return -1;
+
+    // Validate against the panel, not just the client-declared ring
+    // geometry: an out-of-bounds region would run the driver's shadow
+    // copy outside its buffer, and the daemon runs as root
+    int32_t status = -1;
+    if (m.slot < (uint32_t)conn->slots &&
+        m.w > 0 && m.h > 0 &&
+        m.w <= conn->width && m.h <= conn->height &&
+        (size_t)m.w * m.h <= conn->slot_size &&
+        m.x >= 0 && m.w <= dev->width && m.x <= dev->width - m.w &&
+        m.y >= 0 && m.h <= dev->height && m.y <= dev->height - m.h) {
+        uint8_t *pixels = conn->shm + m.slot * conn->slot_size;
+        status = it8951_display(dev, pixels, m.x, m.y, m.w, m.h, m.mode);
+    }
+
+    return send_msg(conn->fd, &status, sizeof(status), -1);
+}
+
+int eink_daemon_run(IT8951_USB *dev) {
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (listener < 0) return -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, EINK_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    unlink(EINK_SOCKET_PATH);
+
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listener, 4) < 0) {
+        close(listener);
+        return -1;
+    }
+
+    printf("Daemon listening on %s\n", EINK_SOCKET_PATH);
+
+    Conn conns[MAX_CLIENTS];
+    for (int i = 0; i < MAX_CLIENTS; i++) conns[i].fd = -1;
+
+    while (1) {
+        struct pollfd pfds[MAX_CLIENTS + 1];
+        int map[MAX_CLIENTS + 1];
+        int n = 0;
+
+        pfds[n].fd = listener;
+        pfds[n].events = POLLIN;
+        map[n++] = -1;
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            if (conns[i].fd >= 0) {
+                pfds[n].fd = conns[i].fd;
+                pfds[n].events = POLLIN;
+                map[n++] = i;
+            }
+        }
+
+        if (poll(pfds, n, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int p = 0; p < n; p++) {
+            if (!(pfds[p].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            if (map[p] < 0) {
+                // New producer
+                int fd = accept(listener, NULL, NULL);
+                if (fd < 0) continue;
+                int slot = -1;
+                for (int i = 0; i < MAX_CLIENTS; i++) {
+                    if (conns[i].fd < 0) { slot = i; break; }
+                }
+                if (slot < 0) {
+                    close(fd);
+                    continue;
+                }
+                memset(&conns[slot], 0, sizeof(Conn));
+                conns[slot].fd = fd;
+                if (conn_setup(&conns[slot]) < 0) conn_close(&conns[slot]);
+            } else {
+                Conn *conn = &conns[map[p]];
+                if (conn_frame(conn, dev) < 0) conn_close(conn);
+            }
+        }
+    }
+
+    close(listener);
+    unlink(EINK_SOCKET_PATH);
+    return 0;
+}
+
+EinkClient* eink_client_connect(int width, int height) {
+    EinkClient *c = calloc(1, sizeof(EinkClient));
+    if (!c) return NULL;
+    c->shm_fd = -1;
+
+    c->sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (c->sock < 0) {
+        free(c);
+        return NULL;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, EINK_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(c->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(c->sock);
+        free(c);
+        return NULL;
+    }
+
+    c->width = width;
+    c->height = height;
+    c->slots = EINK_RING_SLOTS;
+    c->slot_size = (size_t)width * height;
+
+    // Sealed against shrinking so the daemon can trust the mapping length
+    c->shm_fd = memfd_create("eink-frames", MFD_ALLOW_SEALING);
+    if (c->shm_fd < 0 ||
+        ftruncate(c->shm_fd, c->slot_size * c->slots) < 0 ||
+        fcntl(c->shm_fd, F_ADD_SEALS, F_SEAL_SHRINK) < 0) {
+        eink_client_close(c);
+        return NULL;
+    }
+    c->shm = mmap(NULL, c->slot_size * c->slots, PROT_READ | PROT_WRITE,
+                  MAP_SHARED, c->shm_fd, 0);
+    if (c->shm == MAP_FAILED) {
+        c->shm = NULL;
+        eink_client_close(c);
+        return NULL;
+    }
+
+    EinkHello hello = { EINK_HELLO_MAGIC, width, height, c->slots };
+    if (send_msg(c->sock, &hello, sizeof(hello), c->shm_fd) < 0) {
+        eink_client_close(c);
+        return NULL;
+    }
+    return c;
+}
+
+int eink_client_display(EinkClient *c, const uint8_t *pixels,
+                        int x, int y, int w, int h, int mode) {
+    if ((size_t)w * h > c->slot_size) return -1;
+
+    int slot = c->next_slot;
+    c->next_slot = (c->next_slot + 1) % c->slots;
+    memcpy(c->shm + slot * c->slot_size, pixels, (size_t)w * h);
+
+    EinkFrameMsg m = { (uint32_t)slot, x, y, w, h, mode };
+    if (send_msg(c->sock, &m, sizeof(m), -1) < 0) return -1;
+
+    int32_t status;
+    if (recv_msg(c->sock, &status, sizeof(status), NULL) < 0) return -1;
+    return status;
+}
+
+void eink_client_close(EinkClient *c) {
+    if (!c) return;
+    if (c->shm) munmap(c->shm, c->slot_size * c->slots);
+    if (c->shm_fd >= 0) close(c->shm_fd);
+    if (c->sock >= 0) close(c->sock);
+    free(c);
+}
@@ -0,0 +1,63 @@
+/**
+ * Daemon mode - warm device handle shared by multiple producers
+ *
+ * The daemon holds the SG device open and accepts frames over a Unix
+ * socket. Pixel payloads travel in a client-created shared-memory ring
+ * (memfd passed over the socket), so "display this frame" is a
+ * millisecond-scale IPC call instead of a process spawn plus device
+ * re-handshake.
+ */
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "it8951_usb.h"
+#include <stddef.h>
+
+#define EINK_SOCKET_PATH "/tmp/eink-camera.sock"
+#define EINK_RING_SLOTS 2
+
+// Client hello: ring geometry, memfd follows as SCM_RIGHTS
+typedef struct {
+    uint32_t magic;     // 'E8DM'
+    uint32_t width;     // Slot dimensions
+    uint32_t height;
+    uint32_t slots;
+} EinkHello;
+
+#define EINK_HELLO_MAGIC 0x4538444d
+
+// Per-frame command; payload lives in ring slot `slot`
+typedef struct {
+    uint32_t slot;
+    int32_t x, y, w, h;  // Panel region the slot's w x h pixels cover
+    int32_t mode;        // MODE_* waveform
+} EinkFrameMsg;
+
+// Serve frames forever (until the process is signalled).
+// Returns -1 if the socket could not be created.
+int eink_daemon_run(IT8951_USB *dev);
+
+// --- Client side ---
+
+typedef struct {
+    int sock;
+    int shm_fd;
+    uint8_t *shm;
+    size_t slot_size;
+    int slots;
+    int next_slot;
+    int width, height;
+} EinkClient;
+
+// Connect to a running daemon and set up a ring of w x h frame slots
+EinkClient* eink_client_connect(int width, int height);
+
+// Copy pixels (w x h, 8-bit gray) into the next ring slot and submit it
+// for display at (x, y). Blocks until the daemon acknowledges.
+int eink_client_display(EinkClient *c, const uint8_t *pixels,
+                        int x, int y, int w, int h, int mode);
+
+void eink_client_close(EinkClient *c);
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * ER8 raw framebuffer file format - see er8.h
+ */
+
+#include "er8.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int er8_write(const char *path, const uint8_t *pixels, int w, int h) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    ER8Header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, ER8_MAGIC, 4);
+    hdr.width = w;
+    hdr.height = h;
+    hdr.bpp = 8;
+    hdr.offset = ER8_PAYLOAD_OFFSET;
+
+    // Header page, zero-padded to the payload offset
+    uint8_t page[ER8_PAYLOAD_OFFSET];
+    memset(page, 0, sizeof(page));
+    memcpy(page, &hdr, sizeof(hdr));
+
+    if (fwrite(page, 1, sizeof(page), f) != sizeof(page) ||
+        fwrite(pixels, 1, (size_t)w * h, f) != (size_t)w * h) {
+        fclose(f);
+        unlink(path);
+        return -1;
+    }
+    fclose(f);
+    return 0;
+}
+
+ER8File* er8_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(ER8Header)) {
+        close(fd);
+        return NULL;
+    }
+
+    uint8_t *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    ER8Header *hdr = (ER8Header *)map;
+    if (memcmp(hdr->magic, ER8_MAGIC, 4) != 0 || hdr->bpp != 8 ||
+        hdr->width == 0 || hdr->height == 0 ||
+        (off_t)hdr->offset + (off_t)hdr->width * hdr->height > st.st_size) {
+        munmap(map, st.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    ER8File *f = malloc(sizeof(ER8File));
+    if (!f) {
+        munmap(map, st.st_size);
+        close(fd);
+        return NULL;
+    }
+    f->fd = fd;
+    f->map_len = st.st_size;
+    f->map = map;
+    f->pixels = map + hdr->offset;
+    f->width = hdr->width;
+    f->height = hdr->height;
+    return f;
+}
+
+void er8_close(ER8File *f) {
+    if (!f) return;
+    munmap(f->map, f->map_len);
+    close(f->fd);
+    free(f);
+}
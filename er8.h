@@ -0,0 +1,46 @@
+/**
+ * ER8 raw framebuffer file format
+ *
+ * Fixed header + page-aligned 8-bit grayscale payload, so a viewer can
+ * mmap() the file and feed pixels straight to the display driver with no
+ * decode step and no intermediate buffer. Display start-up cost becomes
+ * USB transfer alone.
+ */
+
+#ifndef ER8_H
+#define ER8_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ER8_MAGIC "ER8\0"
+#define ER8_PAYLOAD_OFFSET 4096  // Page-aligned pixel payload
+
+// On-disk header (little-endian, lives in the first page)
+typedef struct {
+    char magic[4];       // "ER8\0"
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;        // Bits per pixel (currently always 8)
+    uint32_t offset;     // Byte offset of the pixel payload
+} ER8Header;
+
+// An opened, memory-mapped ER8 file
+typedef struct {
+    int fd;
+    size_t map_len;
+    uint8_t *map;
+    uint8_t *pixels;     // Points into the mapping, page-aligned
+    int width;
+    int height;
+} ER8File;
+
+// Write an 8-bit grayscale image as an ER8 file. Returns 0 on success.
+int er8_write(const char *path, const uint8_t *pixels, int w, int h);
+
+// mmap an ER8 file read-only. Returns NULL on error or bad header.
+ER8File* er8_open(const char *path);
+
+void er8_close(ER8File *f);
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * er8conv - convert a JPEG to the ER8 raw framebuffer format
+ *
+ * Build: make tools
+ * Usage: er8conv input.jpg output.er8 [width height]
+ *
+ * Pre-converting gallery images means power-on to first pixel is bounded
+ * by USB transfer alone: the viewer just mmaps the .er8 and uploads.
+ */
+
+#include "er8.h"
+#include "imgproc.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_WIDTH  1872
+#define DEFAULT_HEIGHT 1404
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("Usage: %s input.jpg output.er8 [width height]\n", argv[0]);
+        return 1;
+    }
+
+    int w = (argc > 4) ? atoi(argv[3]) : DEFAULT_WIDTH;
+    int h = (argc > 4) ? atoi(argv[4]) : DEFAULT_HEIGHT;
+    if (w <= 0 || h <= 0) {
+        fprintf(stderr, "Bad dimensions %dx%d\n", w, h);
+        return 1;
+    }
+
+    uint8_t *gray = imgproc_load_jpeg_gray(argv[1], w, h);
+    if (!gray) {
+        fprintf(stderr, "Failed to decode %s\n", argv[1]);
+        return 1;
+    }
+
+    int ret = er8_write(argv[2], gray, w, h);
+    free(gray);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%s: %dx%d -> %s\n", argv[1], w, h, argv[2]);
+    return 0;
+}
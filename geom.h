@@ -0,0 +1,36 @@
+/**
+ * Compile-time panel geometry specialization
+ *
+ * The driver treats geometry as runtime values, which leaves per-row
+ * address math and stride-dependent loops opaque to the compiler. We
+ * only ship two panel geometries, so the hot pixel kernels are also
+ * instantiated with the compiled-in width as a constant (via forced
+ * inlining of a width-parameterized body), giving the compiler constant
+ * strides to unroll and vectorize against. Frames that don't match the
+ * compiled geometry fall back to the generic runtime path.
+ *
+ * Select with:  make              (landscape 1872x1404, default)
+ *               make GEOM=portrait  (1404x1872)
+ */
+
+#ifndef GEOM_H
+#define GEOM_H
+
+#ifdef EINK_GEOM_PORTRAIT
+#define EINK_GEOM_WIDTH  1404
+#define EINK_GEOM_HEIGHT 1872
+#else
+#define EINK_GEOM_WIDTH  1872
+#define EINK_GEOM_HEIGHT 1404
+#endif
+
+// True when a frame can take the specialized (constant-stride) kernels
+static inline int geom_matches(int w, int h) {
+    return w == EINK_GEOM_WIDTH && h == EINK_GEOM_HEIGHT;
+}
+
+// Forces the width-parameterized kernel bodies to inline at each call
+// site, so calls with a literal width compile to specialized code
+#define GEOM_INLINE __attribute__((always_inline)) static inline
+
+#endif
@@ -0,0 +1,502 @@
+/**
+ * Native image processing - JPEG decode and resize
+ *
+ * libjpeg decodes straight to grayscale (no YCbCr->RGB->gray detour) and
+ * the resize runs in fixed point, vectorized with NEON where available.
+ * No child processes, no /tmp files.
+ */
+
+#include "imgproc.h"
+#include "workers.h"
+#include "geom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+// Vertical lerp of two source rows into a temp row: out = a + (b-a)*fy
+// fy is a 0..256 fixed-point fraction
+static void lerp_rows(const uint8_t *a, const uint8_t *b, uint8_t *out,
+                      int n, int fy) {
+    int i = 0;
+#ifdef __ARM_NEON
+    uint16x8_t vfy = vdupq_n_u16(fy);
+    uint16x8_t vinv = vdupq_n_u16(256 - fy);
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t va = vmovl_u8(vld1_u8(a + i));
+        uint16x8_t vb = vmovl_u8(vld1_u8(b + i));
+        uint16x8_t acc = vmlaq_u16(vmulq_u16(va, vinv), vb, vfy);
+        vst1_u8(out + i, vqmovn_u16(vshrq_n_u16(acc, 8)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = (uint8_t)((a[i] * (256 - fy) + b[i] * fy) >> 8);
+    }
+}
+
+typedef struct {
+    const uint8_t *src;
+    int sw, sh;
+    uint8_t *dst;
+    int dw, dh;
+    int *x0, *fx;
+} ResizeCtx;
+
+// Resize a band of output rows; independent per band so the worker pool
+// can spread bands across cores
+static void resize_band(int band_y0, int rows, void *arg) {
+    ResizeCtx *c = arg;
+    uint8_t *row = malloc(c->sw);
+    if (!row) return;
+
+    for (int y = band_y0; y < band_y0 + rows; y++) {
+        int pos = (int)(((int64_t)y * (c->sh - 1) << 8) / (c->dh > 1 ? c->dh - 1 : 1));
+        int y0 = pos >> 8;
+        int fy = pos & 0xFF;
+        int y1 = (y0 + 1 < c->sh) ? y0 + 1 : y0;
+
+        // Blend the two source rows once, then sample horizontally
+        lerp_rows(c->src + (size_t)y0 * c->sw, c->src + (size_t)y1 * c->sw,
+                  row, c->sw, fy);
+
+        uint8_t *out = c->dst + (size_t)y * c->dw;
+        for (int x = 0; x < c->dw; x++) {
+            int a = row[c->x0[x]];
+            int b = row[(c->x0[x] + 1 < c->sw) ? c->x0[x] + 1 : c->x0[x]];
+            out[x] = (uint8_t)((a * (256 - c->fx[x]) + b * c->fx[x]) >> 8);
+        }
+    }
+    free(row);
+}
+
+void imgproc_resize_bilinear(const uint8_t *src, int sw, int sh,
+                             uint8_t *dst, int dw, int dh) {
+    if (sw == dw && sh == dh) {
+        memcpy(dst, src, (size_t)sw * sh);
+        return;
+    }
+
+    // Precompute horizontal sample positions and 8.8 fractions
+    int *x0 = malloc(dw * sizeof(int));
+    int *fx = malloc(dw * sizeof(int));
+    if (!x0 || !fx) {
+        free(x0); free(fx);
+        return;
+    }
+    for (int x = 0; x < dw; x++) {
+        int pos = (int)(((int64_t)x * (sw - 1) << 8) / (dw > 1 ? dw - 1 : 1));
+        x0[x] = pos >> 8;
+        fx[x] = pos & 0xFF;
+    }
+
+    ResizeCtx ctx = { src, sw, sh, dst, dw, dh, x0, fx };
+    // Bands of 32 rows match the ~32-line chunks a full-width
+    // it8951_display() transfer uses
+    workers_run(resize_band, dh, 32, &ctx, NULL, NULL);
+
+    free(x0);
+    free(fx);
+}
+
+// libjpeg's default error manager exit()s the process on any fatal
+// decode error, so a truncated capture or a corrupt network frame would
+// kill an unattended camera. Override error_exit to longjmp back into
+// the decode that installed it, which then fails the call instead.
+typedef struct {
+    struct jpeg_error_mgr mgr;
+    jmp_buf escape;
+} JpegErrCtx;
+
+static void jpeg_escape(j_common_ptr cinfo) {
+    JpegErrCtx *ctx = (JpegErrCtx *)cinfo->err;
+    (*cinfo->err->output_message)(cinfo);  // One line on stderr, as before
+    longjmp(ctx->escape, 1);
+}
+
+// Attach the escaping error manager; call before jpeg_create_decompress
+static void jpeg_err_init(struct jpeg_decompress_struct *cinfo, JpegErrCtx *ctx) {
+    cinfo->err = jpeg_std_error(&ctx->mgr);
+    ctx->mgr.error_exit = jpeg_escape;
+}
+
+// Decode directly to grayscale; let libjpeg's DCT scaling do a cheap
+// coarse downscale so later passes work on less data
+static void choose_gray_scale(struct jpeg_decompress_struct *cinfo,
+                              int out_w, int out_h) {
+    cinfo->out_color_space = JCS_GRAYSCALE;
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = 1;
+    while (cinfo->scale_denom < 8 &&
+           (int)(cinfo->image_width / (cinfo->scale_denom * 2)) >= out_w &&
+           (int)(cinfo->image_height / (cinfo->scale_denom * 2)) >= out_h) {
+        cinfo->scale_denom *= 2;
+    }
+}
+
+// Shared decode tail: cinfo already has a data source attached and a
+// JpegErrCtx installed. Reads the header, grayscale-decodes with DCT
+// downscaling, resizes. Re-arms the escape here so a fatal error midway
+// through the scanline loop frees the partial frame and returns NULL.
+static uint8_t* decode_gray(struct jpeg_decompress_struct *cinfo,
+                            int out_w, int out_h) {
+    JpegErrCtx *err = (JpegErrCtx *)cinfo->err;
+    uint8_t * volatile decoded = NULL;
+    if (setjmp(err->escape)) {
+        free(decoded);
+        return NULL;
+    }
+
+    if (jpeg_read_header(cinfo, TRUE) != JPEG_HEADER_OK) {
+        return NULL;
+    }
+
+    choose_gray_scale(cinfo, out_w, out_h);
+    jpeg_start_decompress(cinfo);
+
+    int sw = cinfo->output_width;
+    int sh = cinfo->output_height;
+    decoded = malloc((size_t)sw * sh);
+    if (!decoded) {
+        jpeg_abort_decompress(cinfo);
+        return NULL;
+    }
+
+    while (cinfo->output_scanline < cinfo->output_height) {
+        uint8_t *rowp = decoded + (size_t)cinfo->output_scanline * sw;
+        jpeg_read_scanlines(cinfo, &rowp, 1);
+    }
+
+    jpeg_finish_decompress(cinfo);
+
+    if (sw == out_w && sh == out_h) {
+        return decoded;
+    }
+
+    uint8_t *resized = malloc((size_t)out_w * out_h);
+    if (resized) {
+        imgproc_resize_bilinear(decoded, sw, sh, resized, out_w, out_h);
+    }
+    free(decoded);
+    return resized;
+}
+
+uint8_t* imgproc_load_jpeg_gray(const char *filename, int out_w, int out_h) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) return NULL;
+
+    struct jpeg_decompress_struct cinfo;
+    JpegErrCtx err;
+    jpeg_err_init(&cinfo, &err);
+    if (setjmp(err.escape)) {  // Fatal error before decode_gray re-arms
+        jpeg_destroy_decompress(&cinfo);
+        fclose(f);
+        return NULL;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, f);
+
+    uint8_t *out = decode_gray(&cinfo, out_w, out_h);
+
+    jpeg_destroy_decompress(&cinfo);
+    fclose(f);
+    return out;
+}
+
+int imgproc_stream_jpeg_gray(const char *filename, int out_w, int out_h,
+                             int band_rows, imgproc_band_fn band, void *ctx) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) return -1;
+
+    struct jpeg_decompress_struct cinfo;
+    JpegErrCtx err;
+    uint8_t * volatile buf = NULL;
+    jpeg_err_init(&cinfo, &err);
+    if (setjmp(err.escape)) {  // Fatal error anywhere in the decode
+        jpeg_destroy_decompress(&cinfo);
+        fclose(f);
+        free(buf);
+        return -1;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, f);
+
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(f);
+        return -1;
+    }
+
+    choose_gray_scale(&cinfo, out_w, out_h);
+
+    // Streaming only works without a resize pass: the decoded size must
+    // land exactly on the target. Caller falls back to the full decode.
+    jpeg_calc_output_dimensions(&cinfo);
+    if ((int)cinfo.output_width != out_w || (int)cinfo.output_height != out_h) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(f);
+        return -1;
+    }
+
+    if (band_rows < 1) band_rows = 1;
+    buf = malloc((size_t)band_rows * out_w);
+    if (!buf) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(f);
+        return -1;
+    }
+
+    jpeg_start_decompress(&cinfo);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        int y0 = (int)cinfo.output_scanline;
+        int rows = 0;
+        while (rows < band_rows && cinfo.output_scanline < cinfo.output_height) {
+            uint8_t *rowp = buf + (size_t)rows * out_w;
+            jpeg_read_scanlines(&cinfo, &rowp, 1);
+            rows++;
+        }
+        band(buf, y0, rows, ctx);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    fclose(f);
+    free(buf);
+    return 0;
+}
+
+uint8_t* imgproc_decode_jpeg_gray(const uint8_t *data, size_t len,
+                                  int out_w, int out_h) {
+    struct jpeg_decompress_struct cinfo;
+    JpegErrCtx err;
+    jpeg_err_init(&cinfo, &err);
+    if (setjmp(err.escape)) {  // Fatal error before decode_gray re-arms
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, len);
+
+    uint8_t *out = decode_gray(&cinfo, out_w, out_h);
+
+    jpeg_destroy_decompress(&cinfo);
+    return out;
+}
+
+void imgproc_pack_4bpp(const uint8_t *src, uint8_t *dst, int n) {
+    int i = 0;
+#ifdef __ARM_NEON
+    for (; i + 32 <= n; i += 32) {
+        // De-interleave even/odd pixels, keep the high nibbles
+        uint8x16x2_t v = vld2q_u8(src + i);
+        uint8x16_t hi = vandq_u8(v.val[0], vdupq_n_u8(0xF0));
+        uint8x16_t lo = vshrq_n_u8(v.val[1], 4);
+        vst1q_u8(dst + i / 2, vorrq_u8(hi, lo));
+    }
+#endif
+    for (; i + 2 <= n; i += 2) {
+        dst[i / 2] = (uint8_t)((src[i] & 0xF0) | (src[i + 1] >> 4));
+    }
+}
+
+void imgproc_pack_1bpp(const uint8_t *src, uint8_t *dst, int n) {
+    int i = 0;
+#ifdef __ARM_NEON
+    const uint8x8_t bits = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    for (; i + 8 <= n; i += 8) {
+        uint8x8_t v = vcge_u8(vld1_u8(src + i), vdup_n_u8(128));
+        dst[i / 8] = vaddv_u8(vand_u8(v, bits));
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        uint8_t b = 0;
+        for (int j = 0; j < 8; j++) {
+            if (src[i + j] >= 128) b |= (uint8_t)(0x80 >> j);
+        }
+        dst[i / 8] = b;
+    }
+}
+
+// 8x8 Bayer matrix scaled to 0..252 thresholds
+static const uint8_t bayer8[8][8] = {
+    {   0, 128,  32, 160,   8, 136,  40, 168 },
+    { 192,  64, 224,  96, 200,  72, 232, 104 },
+    {  48, 176,  16, 144,  56, 184,  24, 152 },
+    { 240, 112, 208,  80, 248, 120, 216,  88 },
+    {  12, 140,  44, 172,   4, 132,  36, 164 },
+    { 204,  76, 236, 108, 196,  68, 228, 100 },
+    {  60, 188,  28, 156,  52, 180,  20, 148 },
+    { 252, 124, 220,  92, 244, 116, 212,  84 },
+};
+
+typedef struct {
+    const uint8_t *src;
+    uint8_t *dst;
+    int w;
+} DitherCtx;
+
+// Width-parameterized body: called once with the compiled-in panel width
+// as a literal (constant stride, fully unrollable) and once with the
+// runtime width as the generic fallback - see geom.h
+GEOM_INLINE void dither_ordered_rows(const uint8_t *srcp, uint8_t *dstp,
+                                     int w, int y0, int rows) {
+    for (int y = y0; y < y0 + rows; y++) {
+        const uint8_t *trow = bayer8[y & 7];
+        const uint8_t *src = srcp + (size_t)y * w;
+        uint8_t *dst = dstp + (size_t)y * w;
+        int x = 0;
+#ifdef __ARM_NEON
+        uint8x8_t vt = vld1_u8(trow);
+        for (; x + 8 <= w; x += 8) {
+            // pixel > threshold -> 0xFF, else 0x00
+            vst1_u8(dst + x, vcgt_u8(vld1_u8(src + x), vt));
+        }
+#endif
+        for (; x < w; x++) {
+            dst[x] = (src[x] > trow[x & 7]) ? 0xFF : 0x00;
+        }
+    }
+}
+
+static void dither_ordered_band(int y0, int rows, void *arg) {
+    DitherCtx *c = arg;
+    if (c->w == EINK_GEOM_WIDTH) {
+        dither_ordered_rows(c->src, c->dst, EINK_GEOM_WIDTH, y0, rows);
+    } else {
+        dither_ordered_rows(c->src, c->dst, c->w, y0, rows);
+    }
+}
+
+void imgproc_dither_ordered(const uint8_t *src, uint8_t *dst, int w, int h) {
+    DitherCtx ctx = { src, dst, w };
+    workers_run(dither_ordered_band, h, 32, &ctx, NULL, NULL);
+}
+
+void imgproc_tone_stats(const uint8_t *p, size_t n, uint64_t out[3]) {
+    uint64_t dark = 0, light = 0;
+    size_t i = 0;
+#ifdef __ARM_NEON
+    uint8x16_t lo = vdupq_n_u8(32), hi = vdupq_n_u8(224);
+    while (i + 16 <= n) {
+        // Accumulate compare masks in 8-bit lanes (0xFF == -1) for up to
+        // 255 vectors before widening, the usual NEON popcount trick
+        uint8x16_t accd = vdupq_n_u8(0), accl = vdupq_n_u8(0);
+        int iters = 0;
+        for (; i + 16 <= n && iters < 255; i += 16, iters++) {
+            uint8x16_t v = vld1q_u8(p + i);
+            accd = vsubq_u8(accd, vcleq_u8(v, lo));
+            accl = vsubq_u8(accl, vcgeq_u8(v, hi));
+        }
+        dark += vaddlvq_u8(accd);
+        light += vaddlvq_u8(accl);
+    }
+#endif
+    for (; i < n; i++) {
+        if (p[i] <= 32) dark++;
+        else if (p[i] >= 224) light++;
+    }
+    out[0] = dark;
+    out[1] = n - dark - light;
+    out[2] = light;
+}
+
+typedef struct {
+    const uint8_t *a, *b;
+    int w;
+    int band_rows;
+    uint8_t *band_max;  // Per-band maximum tile mean, merged by the caller
+} ChangeCtx;
+
+// Max per-tile mean absolute difference within one band of rows.
+// Tiles are 64 pixels wide by the band height, so a small moving object
+// still dominates its tile instead of drowning in the frame average.
+// Width-parameterized for the geom.h constant-stride instantiation.
+GEOM_INLINE int change_rows(const uint8_t *a, const uint8_t *b,
+                            int w, int y0, int rows) {
+    int max_mean = 0;
+
+    for (int x = 0; x < w; x += 64) {
+        int bw = (x + 64 <= w) ? 64 : w - x;
+        uint32_t sad = 0;
+        for (int y = y0; y < y0 + rows; y++) {
+            const uint8_t *pa = a + (size_t)y * w + x;
+            const uint8_t *pb = b + (size_t)y * w + x;
+            int i = 0;
+#ifdef __ARM_NEON
+            uint16x8_t acc = vdupq_n_u16(0);
+            for (; i + 16 <= bw; i += 16) {
+                acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(pa + i),
+                                               vld1q_u8(pb + i)));
+            }
+            sad += vaddvq_u16(acc);
+#endif
+            for (; i < bw; i++) {
+                int d = pa[i] - pb[i];
+                sad += (uint32_t)(d < 0 ? -d : d);
+            }
+        }
+        int mean = (int)(sad / (uint32_t)(bw * rows));
+        if (mean > max_mean) max_mean = mean;
+    }
+    return max_mean;
+}
+
+static void change_band(int y0, int rows, void *arg) {
+    ChangeCtx *c = arg;
+    int max_mean = (c->w == EINK_GEOM_WIDTH)
+        ? change_rows(c->a, c->b, EINK_GEOM_WIDTH, y0, rows)
+        : change_rows(c->a, c->b, c->w, y0, rows);
+    c->band_max[y0 / c->band_rows] = (uint8_t)(max_mean > 255 ? 255 : max_mean);
+}
+
+int imgproc_frame_change(const uint8_t *a, const uint8_t *b, int w, int h) {
+    enum { BAND = 32 };
+    int bands = (h + BAND - 1) / BAND;
+    uint8_t *band_max = calloc(bands, 1);
+    if (!band_max) return 255;  // Can't tell: report full change
+
+    ChangeCtx ctx = { a, b, w, BAND, band_max };
+    workers_run(change_band, h, BAND, &ctx, NULL, NULL);
+
+    int max = 0;
+    for (int i = 0; i < bands; i++) {
+        if (band_max[i] > max) max = band_max[i];
+    }
+    free(band_max);
+    return max;
+}
+
+void imgproc_dither_fs(const uint8_t *src, uint8_t *dst, int w, int h) {
+    // Running error for the current and next row, with 1px padding
+    int16_t *err = calloc(2 * (w + 2), sizeof(int16_t));
+    if (!err) {
+        imgproc_dither_ordered(src, dst, w, h);
+        return;
+    }
+    int16_t *cur = err + 1;
+    int16_t *next = err + (w + 2) + 1;
+
+    for (int y = 0; y < h; y++) {
+        memset(next - 1, 0, (w + 2) * sizeof(int16_t));
+        const uint8_t *src_row = src + (size_t)y * w;
+        uint8_t *dst_row = dst + (size_t)y * w;
+
+        for (int x = 0; x < w; x++) {
+            int v = src_row[x] + cur[x];
+            uint8_t out = (v >= 128) ? 0xFF : 0x00;
+            dst_row[x] = out;
+            int e = v - out;
+            cur[x + 1] += (e * 7) >> 4;
+            next[x - 1] += (e * 3) >> 4;
+            next[x]     += (e * 5) >> 4;
+            next[x + 1] += e >> 4;
+        }
+        int16_t *tmp = cur;
+        cur = next;
+        next = tmp;
+    }
+    free(err);
+}
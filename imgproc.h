@@ -0,0 +1,59 @@
+/**
+ * Native image processing - JPEG decode and resize
+ * Replaces the forked ImageMagick convert + /tmp round trip
+ */
+
+#ifndef IMGPROC_H
+#define IMGPROC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Decode a JPEG straight to 8-bit grayscale and bilinear-resize to
+// out_w x out_h. Returns a malloc'd buffer (caller frees) or NULL.
+uint8_t* imgproc_load_jpeg_gray(const char *filename, int out_w, int out_h);
+
+// Same, but from an in-memory JPEG (network frames, captured buffers)
+uint8_t* imgproc_decode_jpeg_gray(const uint8_t *data, size_t len,
+                                  int out_w, int out_h);
+
+// Streaming decode: decompress in bands of band_rows scanlines and hand
+// each band to the callback as it is produced, so peak memory is one
+// band instead of a full frame. Only possible when the decoded size
+// (after DCT downscaling) is exactly out_w x out_h - returns -1
+// otherwise and the caller should fall back to imgproc_load_jpeg_gray.
+typedef void (*imgproc_band_fn)(const uint8_t *rows, int y, int h, void *ctx);
+int imgproc_stream_jpeg_gray(const char *filename, int out_w, int out_h,
+                             int band_rows, imgproc_band_fn band, void *ctx);
+
+// Bilinear resize of an 8-bit grayscale image (NEON-accelerated on ARM)
+void imgproc_resize_bilinear(const uint8_t *src, int sw, int sh,
+                             uint8_t *dst, int dw, int dh);
+
+// Pack 8bpp grayscale to 4bpp nibbles (first pixel in the high nibble).
+// n must be even; dst holds n/2 bytes.
+void imgproc_pack_4bpp(const uint8_t *src, uint8_t *dst, int n);
+
+// Pack 8bpp grayscale to 1bpp by thresholding at 128 (MSB first).
+// n must be a multiple of 8; dst holds n/8 bytes.
+void imgproc_pack_1bpp(const uint8_t *src, uint8_t *dst, int n);
+
+// Ordered 8x8 Bayer dither to bilevel 0x00/0xFF (NEON-accelerated,
+// band-parallel). src and dst may alias.
+void imgproc_dither_ordered(const uint8_t *src, uint8_t *dst, int w, int h);
+
+// Floyd-Steinberg error diffusion to bilevel 0x00/0xFF. Serial (the error
+// propagates), but better midtones than the ordered kernel.
+void imgproc_dither_fs(const uint8_t *src, uint8_t *dst, int w, int h);
+
+// Tone census for the waveform auto-selector: counts near-black (<=32),
+// midtone, and near-white (>=224) pixels into out[0..2] (NEON-accelerated)
+void imgproc_tone_stats(const uint8_t *p, size_t n, uint64_t out[3]);
+
+// Scene-change metric: maximum per-tile (64x32) mean absolute difference
+// between two frames, 0..255 (NEON-accelerated, band-parallel). Sensor
+// noise on a static scene scores a few counts; real motion pushes at
+// least one tile well past that, so a small threshold gates reliably.
+int imgproc_frame_change(const uint8_t *a, const uint8_t *b, int w, int h);
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * Input subsystem - see input.h
+ *
+ * The button uses the gpiochip character device (GPIO uAPI v2): the
+ * line is requested with both edges, a pull-up and kernel debounce, and
+ * the thread sleeps in poll() until an edge arrives - no polling
+ * wakeups, sub-millisecond latency. While the button is down the poll
+ * timeout shrinks to the hold deadline so INPUT_HOLD fires the moment
+ * the threshold passes, not on release.
+ *
+ * The queue is a single-producer single-consumer ring on C11 atomics;
+ * a self-pipe wakes the consumer so input_next() can block without
+ * taking a lock on the hot path.
+ */
+
+#include "input.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+// Ring size must be a power of two (index masking)
+#define QUEUE_SIZE 32
+
+static InputEvent queue[QUEUE_SIZE];
+static _Atomic unsigned q_head;  // Written by the event thread only
+static _Atomic unsigned q_tail;  // Written by the consumer only
+
+static pthread_t input_thread;
+static int input_started;
+static int line_fd = -1;         // GPIO line event fd, -1 if no button
+static int quit_pipe[2] = { -1, -1 };
+static int notify_pipe[2] = { -1, -1 };
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Producer side: drop the event if the consumer has fallen a full ring
+// behind - stale input is worse than lost input for a camera button
+static void push_event(int type, char ch) {
+    unsigned head = atomic_load_explicit(&q_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&q_tail, memory_order_acquire);
+    if (head - tail >= QUEUE_SIZE) return;
+
+    queue[head & (QUEUE_SIZE - 1)].type = type;
+    queue[head & (QUEUE_SIZE - 1)].ch = ch;
+    atomic_store_explicit(&q_head, head + 1, memory_order_release);
+
+    char b = 0;
+    if (write(notify_pipe[1], &b, 1) < 0) { /* consumer is full anyway */ }
+}
+
+static int pop_event(InputEvent *ev) {
+    unsigned tail = atomic_load_explicit(&q_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&q_head, memory_order_acquire);
+    if (tail == head) return 0;
+
+    *ev = queue[tail & (QUEUE_SIZE - 1)];
+    atomic_store_explicit(&q_tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// Request the button line from one gpiochip; returns the event fd or -1
+static int open_button(const char *chip_path) {
+    int chip = open(chip_path, O_RDWR);
+    if (chip < 0) return -1;
+
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = INPUT_BUTTON_GPIO;
+    req.num_lines = 1;
+    strncpy(req.consumer, "eink-camera", sizeof(req.consumer) - 1);
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT |
+                       GPIO_V2_LINE_FLAG_EDGE_RISING |
+                       GPIO_V2_LINE_FLAG_EDGE_FALLING |
+                       GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+    // Kernel-side debounce: mechanical buttons bounce for a few ms
+    req.config.num_attrs = 1;
+    req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+    req.config.attrs[0].attr.debounce_period_us = 5000;
+    req.config.attrs[0].mask = 1;
+
+    int ret = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &req);
+    close(chip);
+    if (ret < 0 || req.fd < 0) return -1;
+    return req.fd;
+}
+
+static void *input_loop(void *arg) {
+    (void)arg;
+    int down = 0;        // Button currently pressed
+    int hold_sent = 0;   // INPUT_HOLD already emitted for this press
+    double down_at = 0;
+
+    struct pollfd fds[3];
+    fds[0].fd = quit_pipe[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = STDIN_FILENO;
+    fds[1].events = POLLIN;
+    fds[2].fd = line_fd;
+    fds[2].events = POLLIN;
+    int nfds = (line_fd >= 0) ? 3 : 2;
+
+    while (1) {
+        // Idle: sleep until an edge or a key. Button down: wake at the
+        // hold deadline so the hold event fires while still pressed.
+        int timeout = -1;
+        if (down && !hold_sent) {
+            timeout = (int)(down_at + INPUT_HOLD_MS - now_ms());
+            if (timeout < 0) timeout = 0;
+        }
+
+        int n = poll(fds, nfds, timeout);
+        if (n < 0) continue;
+
+        if (n == 0) {
+            // Hold deadline passed with the button still down
+            if (down && !hold_sent) {
+                hold_sent = 1;
+                push_event(INPUT_HOLD, 0);
+            }
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) break;  // input_stop()
+
+        if (fds[1].revents & POLLIN) {
+            char c;
+            if (read(STDIN_FILENO, &c, 1) == 1) {
+                push_event(INPUT_KEY, c);
+            }
+        }
+
+        if (nfds > 2 && (fds[2].revents & POLLIN)) {
+            struct gpio_v2_line_event ev;
+            if (read(line_fd, &ev, sizeof(ev)) == sizeof(ev)) {
+                if (ev.id == GPIO_V2_LINE_EVENT_FALLING_EDGE) {
+                    // Pull-up wiring: falling edge = press
+                    down = 1;
+                    hold_sent = 0;
+                    down_at = now_ms();
+                } else if (down) {
+                    if (!hold_sent) push_event(INPUT_PRESS, 0);
+                    down = 0;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+int input_start(void) {
+    if (input_started) return 0;
+
+    if (pipe(quit_pipe) < 0 || pipe(notify_pipe) < 0) return -1;
+    fcntl(notify_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(notify_pipe[1], F_SETFL, O_NONBLOCK);
+
+    // Pi 5 routes the 40-pin header through gpiochip4; older Pis use
+    // gpiochip0. Keyboard-only operation when neither has our line.
+    line_fd = open_button("/dev/gpiochip4");
+    if (line_fd < 0) line_fd = open_button("/dev/gpiochip0");
+    if (line_fd >= 0) {
+        printf("Button on GPIO%d ready\n", INPUT_BUTTON_GPIO);
+    }
+
+    if (pthread_create(&input_thread, NULL, input_loop, NULL) != 0) {
+        if (line_fd >= 0) close(line_fd);
+        line_fd = -1;
+        return -1;
+    }
+    input_started = 1;
+    return 0;
+}
+
+int input_next(InputEvent *ev, int timeout_ms) {
+    if (pop_event(ev)) return 1;
+    if (timeout_ms == 0) return 0;
+
+    struct pollfd pfd = { notify_pipe[0], POLLIN, 0 };
+    poll(&pfd, 1, timeout_ms);
+
+    // Drain stale wakeup bytes, then try again
+    char buf[QUEUE_SIZE];
+    while (read(notify_pipe[0], buf, sizeof(buf)) > 0) {}
+    return pop_event(ev);
+}
+
+void input_stop(void) {
+    if (!input_started) return;
+
+    char b = 0;
+    if (write(quit_pipe[1], &b, 1) < 0) { /* never full: one byte per stop */ }
+    pthread_join(input_thread, NULL);
+
+    if (line_fd >= 0) close(line_fd);
+    line_fd = -1;
+    close(quit_pipe[0]); close(quit_pipe[1]);
+    close(notify_pipe[0]); close(notify_pipe[1]);
+    input_started = 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * Input subsystem - GPIO button + keyboard on one event thread
+ *
+ * One thread blocks in poll() on the gpiochip line fd (edge-triggered,
+ * so the button costs zero CPU while idle) and on stdin, and feeds a
+ * lock-free queue the main loop drains. Button semantics match the
+ * Python app: short press = capture, holding past 1.5 s = mode.
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+// Button wiring (matches the Python app): GPIO17 with a pull-up,
+// pressed pulls the line low
+#define INPUT_BUTTON_GPIO 17
+#define INPUT_HOLD_MS     1500
+
+// Event types
+#define INPUT_KEY   1  // Keyboard: ch holds the character
+#define INPUT_PRESS 2  // Button short press (released before the hold threshold)
+#define INPUT_HOLD  3  // Button held past INPUT_HOLD_MS (fires at the threshold)
+
+typedef struct {
+    int type;   // INPUT_*
+    char ch;    // Valid for INPUT_KEY
+} InputEvent;
+
+// Start the event thread. Opens the gpiochip for the button (Pi 5 puts
+// the header on gpiochip4, older Pis on gpiochip0); keyboard-only
+// operation if no chip is available. stdin should already be in raw
+// mode. Returns 0 on success (even without GPIO), -1 if the thread
+// cannot start.
+int input_start(void);
+
+// Wait up to timeout_ms for the next event (0 = just drain, -1 = block
+// forever). Returns 1 with *ev filled, 0 on timeout.
+int input_next(InputEvent *ev, int timeout_ms);
+
+// Stop the event thread and release the GPIO line
+void input_stop(void);
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * Multi-panel fan-out - see it8951_multi.h
+ */
+
+#include "it8951_multi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+IT8951_Set* it8951_set_open(const char **devices, int count) {
+    if (count < 1 || count > IT8951_SET_MAX) return NULL;
+
+    IT8951_Set *set = calloc(1, sizeof(IT8951_Set));
+    if (!set) return NULL;
+
+    int x = 0;
+    for (int i = 0; i < count; i++) {
+        set->devs[i] = it8951_usb_open(devices[i]);
+        if (!set->devs[i]) {
+            it8951_set_close(set);
+            return NULL;
+        }
+        set->crop[i] = malloc((size_t)set->devs[i]->width * set->devs[i]->height);
+        if (!set->crop[i]) {
+            it8951_set_close(set);
+            return NULL;
+        }
+        // Default layout: panels side by side
+        set->src_x[i] = x;
+        set->src_y[i] = 0;
+        x += set->devs[i]->width;
+        set->count = i + 1;
+    }
+    return set;
+}
+
+void it8951_set_layout(IT8951_Set *set, int idx, int src_x, int src_y) {
+    if (idx < 0 || idx >= set->count) return;
+    set->src_x[idx] = src_x;
+    set->src_y[idx] = src_y;
+}
+
+typedef struct {
+    IT8951_Set *set;
+    int idx;
+    uint8_t *frame;
+    int frame_w, frame_h;
+    int mode;
+    int ret;
+} PanelJob;
+
+// Phase 1: gather this panel's crop and upload it (bus-parallel per panel)
+static void *panel_upload(void *arg) {
+    PanelJob *job = arg;
+    IT8951_Set *set = job->set;
+    IT8951_USB *dev = set->devs[job->idx];
+    uint8_t *crop = set->crop[job->idx];
+    int pw = dev->width, ph = dev->height;
+
+    // Gather the crop (white outside the source frame)
+    for (int y = 0; y < ph; y++) {
+        int sy = set->src_y[job->idx] + y;
+        uint8_t *dst = crop + (size_t)y * pw;
+        if (sy < 0 || sy >= job->frame_h) {
+            memset(dst, 0xFF, pw);
+            continue;
+        }
+        for (int x = 0; x < pw; x++) {
+            int sx = set->src_x[job->idx] + x;
+            dst[x] = (sx >= 0 && sx < job->frame_w)
+                     ? job->frame[(size_t)sy * job->frame_w + sx] : 0xFF;
+        }
+    }
+
+    job->ret = it8951_upload(dev, crop, 0, 0, pw, ph);
+    return NULL;
+}
+
+// Phase 2: trigger the refresh (one thread per panel so the waveform
+// refreshes run concurrently and start within microseconds of each other)
+static void *panel_refresh(void *arg) {
+    PanelJob *job = arg;
+    IT8951_USB *dev = job->set->devs[job->idx];
+    job->ret |= it8951_refresh(dev, 0, 0, dev->width, dev->height, job->mode);
+    return NULL;
+}
+
+// Run a phase across all panels, one thread each; a panel whose thread
+// can't start just runs inline
+static void run_phase(IT8951_Set *set, PanelJob *jobs, void *(*fn)(void *)) {
+    pthread_t threads[IT8951_SET_MAX];
+    int started[IT8951_SET_MAX] = { 0 };
+
+    for (int i = 0; i < set->count; i++) {
+        started[i] = (pthread_create(&threads[i], NULL, fn, &jobs[i]) == 0);
+        if (!started[i]) fn(&jobs[i]);
+    }
+    for (int i = 0; i < set->count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+}
+
+int it8951_set_display(IT8951_Set *set, uint8_t *frame,
+                       int frame_w, int frame_h, int mode) {
+    PanelJob jobs[IT8951_SET_MAX];
+    for (int i = 0; i < set->count; i++) {
+        jobs[i] = (PanelJob){ set, i, frame, frame_w, frame_h, mode, 0 };
+    }
+
+    // All panels upload first, then all refresh triggers fire together
+    run_phase(set, jobs, panel_upload);
+    run_phase(set, jobs, panel_refresh);
+
+    int ret = 0;
+    for (int i = 0; i < set->count; i++) {
+        ret |= jobs[i].ret;
+    }
+    return ret;
+}
+
+void it8951_set_close(IT8951_Set *set) {
+    if (!set) return;
+    for (int i = 0; i < IT8951_SET_MAX; i++) {
+        if (set->devs[i]) it8951_usb_close(set->devs[i]);
+        free(set->crop[i]);
+    }
+    free(set);
+}
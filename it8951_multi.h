@@ -0,0 +1,39 @@
+/**
+ * Multi-panel fan-out - drive several IT8951 displays as one surface
+ *
+ * Each panel shows a crop of a large source frame. Uploads run on one
+ * thread per panel (the SG_IO transfers are independent and bus-parallel)
+ * and the refresh triggers fire together behind a barrier so all panels
+ * flip visually simultaneously.
+ */
+
+#ifndef IT8951_MULTI_H
+#define IT8951_MULTI_H
+
+#include "it8951_usb.h"
+
+#define IT8951_SET_MAX 8
+
+typedef struct {
+    int count;
+    IT8951_USB *devs[IT8951_SET_MAX];
+    int src_x[IT8951_SET_MAX];   // Crop origin of each panel in the source
+    int src_y[IT8951_SET_MAX];
+    uint8_t *crop[IT8951_SET_MAX];  // Per-panel staging buffer
+} IT8951_Set;
+
+// Open all devices. Default layout tiles panels left to right.
+// Returns NULL if any device fails to open.
+IT8951_Set* it8951_set_open(const char **devices, int count);
+
+// Place panel idx at (src_x, src_y) within the source frame
+void it8951_set_layout(IT8951_Set *set, int idx, int src_x, int src_y);
+
+// Display each panel's crop of the frame (frame_w x frame_h, 8-bit gray).
+// Crops outside the frame are clamped; uploads run concurrently.
+int it8951_set_display(IT8951_Set *set, uint8_t *frame,
+                       int frame_w, int frame_h, int mode);
+
+void it8951_set_close(IT8951_Set *set);
+
+#endif
@@ -4,6 +4,8 @@
  */
 
 #include "it8951_usb.h"
+#include "imgproc.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,9 +15,19 @@
 #include <scsi/sg.h>
 #include <sys/ioctl.h>
 #include <byteswap.h>
+#include <time.h>
+#include <poll.h>
 
 #define IT8951_USB_TIMEOUT 10000
 #define MAX_TRANSFER 60800
+#define MIN_CHUNK 4096
+
+// Monotonic nanoseconds for the transfer counters
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
 
 // Area struct for load_image_area command
 typedef struct {
@@ -55,8 +67,17 @@ typedef struct {
     void *command_table;
 } IT8951_deviceinfo;
 
-// Load image data to display buffer
-static int load_image_area(IT8951_USB *dev, int x, int y, int w, int h, uint8_t *data) {
+// A command only counts as done when the ioctl returned and the SCSI
+// status, host and driver bytes are all clean - a hub glitch often
+// surfaces as a "successful" ioctl carrying a check condition
+static int sgio_failed(int ret, const sg_io_hdr_t *io) {
+    return ret != 0 || io->status != 0 || io->host_status != 0 ||
+           io->driver_status != 0;
+}
+
+// Load image data to display buffer (single attempt; see load_image_area)
+static int load_image_area_once(IT8951_USB *dev, unsigned int addr, int x, int y,
+                                int w, int h, uint8_t *data, int length) {
     unsigned char cmd[16] = {
         0xfe, 0x00, 0x00, 0x00, 0x00, 0x00,
         0xa2, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -65,18 +86,51 @@ static int load_image_area(IT8951_USB *dev, int x, int y, int w, int h, uint8_t
 
     IT8951_area area;
     memset(&area, 0, sizeof(IT8951_area));
-    area.address = dev->img_addr;
+    area.address = addr;
     area.x = __bswap_32(x);
     area.y = __bswap_32(y);
     area.w = __bswap_32(w);
     area.h = __bswap_32(h);
 
-    int length = w * h;
-    uint8_t *buffer = malloc(length + sizeof(IT8951_area));
-    if (!buffer) return -1;
+    // Zero-copy path: hand the header and the caller's pixel pointer to the
+    // SG driver as two iovec segments. Probed on first use; if the device or
+    // sg driver rejects scatter-gather we fall back to the copying path.
+    if (dev->use_iovec) {
+        struct sg_iovec iov[2];
+        iov[0].iov_base = &area;
+        iov[0].iov_len = sizeof(IT8951_area);
+        iov[1].iov_base = data;
+        iov[1].iov_len = length;
+
+        sg_io_hdr_t io_hdr;
+        memset(&io_hdr, 0, sizeof(sg_io_hdr_t));
+        io_hdr.interface_id = 'S';
+        io_hdr.cmd_len = 16;
+        io_hdr.dxfer_direction = SG_DXFER_TO_DEV;
+        io_hdr.dxfer_len = length + sizeof(IT8951_area);
+        io_hdr.dxferp = iov;
+        io_hdr.iovec_count = 2;
+        io_hdr.cmdp = cmd;
+        io_hdr.timeout = dev->timeout_ms;
 
+        uint64_t t0 = now_ns();
+        int ret = ioctl(dev->fd, SG_IO, &io_hdr);
+        dev->stats.sgio_calls++;
+        dev->stats.load_ns += now_ns() - t0;
+        if (!sgio_failed(ret, &io_hdr)) {
+            dev->stats.bytes_sent += length;
+            return 0;
+        }
+        dev->use_iovec = 0;
+    }
+
+    // Write header + payload into the pre-allocated transfer buffer:
+    // no per-chunk malloc, single copy of the pixel data
+    uint8_t *buffer = dev->xfer_buf;
     memcpy(buffer, &area, sizeof(IT8951_area));
-    memcpy(buffer + sizeof(IT8951_area), data, length);
+    if (data != buffer + sizeof(IT8951_area)) {
+        memcpy(buffer + sizeof(IT8951_area), data, length);
+    }
 
     sg_io_hdr_t io_hdr;
     memset(&io_hdr, 0, sizeof(sg_io_hdr_t));
@@ -86,15 +140,39 @@ static int load_image_area(IT8951_USB *dev, int x, int y, int w, int h, uint8_t
     io_hdr.dxfer_len = length + sizeof(IT8951_area);
     io_hdr.dxferp = buffer;
     io_hdr.cmdp = cmd;
-    io_hdr.timeout = IT8951_USB_TIMEOUT;
+    io_hdr.timeout = dev->timeout_ms;
 
+    uint64_t t0 = now_ns();
     int ret = ioctl(dev->fd, SG_IO, &io_hdr);
-    free(buffer);
-    return ret;
+    dev->stats.sgio_calls++;
+    dev->stats.load_ns += now_ns() - t0;
+    if (sgio_failed(ret, &io_hdr)) return -1;
+    dev->stats.bytes_sent += length;
+    return 0;
 }
 
-// Trigger display refresh
-static int display_area(IT8951_USB *dev, int x, int y, int w, int h, int mode) {
+// Track per-tile ghosting: fast (A2/DU) refreshes accumulate, quality
+// (GC16/INIT) refreshes reset the tiles they cover
+static void note_refresh(IT8951_USB *dev, int x, int y, int w, int h, int mode) {
+    int tw = (dev->width + IT8951_TILE_GRID - 1) / IT8951_TILE_GRID;
+    int th = (dev->height + IT8951_TILE_GRID - 1) / IT8951_TILE_GRID;
+    int tx0 = x / tw, tx1 = (x + w - 1) / tw;
+    int ty0 = y / th, ty1 = (y + h - 1) / th;
+    if (tx1 >= IT8951_TILE_GRID) tx1 = IT8951_TILE_GRID - 1;
+    if (ty1 >= IT8951_TILE_GRID) ty1 = IT8951_TILE_GRID - 1;
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            uint32_t *count = &dev->tile_a2[ty * IT8951_TILE_GRID + tx];
+            if (mode == MODE_A2 || mode == MODE_DU) (*count)++;
+            else *count = 0;
+        }
+    }
+    dev->last_update_ns = now_ns();
+}
+
+// Trigger display refresh (single attempt; see display_area)
+static int display_area_once(IT8951_USB *dev, unsigned int addr, int x, int y, int w, int h, int mode) {
     unsigned char cmd[16] = {
         0xfe, 0x00, 0x00, 0x00, 0x00, 0x00,
         0x94, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -103,7 +181,7 @@ static int display_area(IT8951_USB *dev, int x, int y, int w, int h, int mode) {
 
     IT8951_display_area area;
     memset(&area, 0, sizeof(IT8951_display_area));
-    area.address = dev->img_addr;
+    area.address = addr;
     area.wavemode = __bswap_32(mode);
     area.x = __bswap_32(x);
     area.y = __bswap_32(y);
@@ -111,34 +189,36 @@ static int display_area(IT8951_USB *dev, int x, int y, int w, int h, int mode) {
     area.h = __bswap_32(h);
     area.wait_ready = __bswap_32(1);
 
-    uint8_t *buffer = malloc(sizeof(IT8951_display_area));
-    if (!buffer) return -1;
-    memcpy(buffer, &area, sizeof(IT8951_display_area));
-
     sg_io_hdr_t io_hdr;
     memset(&io_hdr, 0, sizeof(sg_io_hdr_t));
     io_hdr.interface_id = 'S';
     io_hdr.cmd_len = 16;
     io_hdr.dxfer_direction = SG_DXFER_TO_DEV;
     io_hdr.dxfer_len = sizeof(IT8951_display_area);
-    io_hdr.dxferp = buffer;
+    io_hdr.dxferp = &area;
     io_hdr.cmdp = cmd;
-    io_hdr.timeout = IT8951_USB_TIMEOUT;
+    io_hdr.timeout = dev->timeout_ms;
 
+    uint64_t t0 = now_ns();
     int ret = ioctl(dev->fd, SG_IO, &io_hdr);
-    free(buffer);
-    return ret;
-}
+    dev->stats.sgio_calls++;
+    dev->stats.refreshes++;
+    dev->stats.display_ns += now_ns() - t0;
+    if (sgio_failed(ret, &io_hdr)) return -1;
 
-IT8951_USB* it8951_usb_open(const char *device) {
-    IT8951_USB *dev = malloc(sizeof(IT8951_USB));
-    if (!dev) return NULL;
+    note_refresh(dev, x, y, w, h, mode);
+    return 0;
+}
 
+// Open the SG node and run the info handshake, filling fd, geometry and
+// the device-side buffer addresses. Used at open and again by the
+// recovery path after a USB drop (the kernel hands out the same node
+// name on re-enumeration).
+static int device_handshake(IT8951_USB *dev, const char *device) {
     dev->fd = open(device, O_RDWR | O_NONBLOCK);
     if (dev->fd < 0) {
         perror("Failed to open device");
-        free(dev);
-        return NULL;
+        return -1;
     }
 
     // Verify it's a SCSI device
@@ -146,8 +226,8 @@ IT8951_USB* it8951_usb_open(const char *device) {
     if (ioctl(dev->fd, SCSI_IOCTL_GET_BUS_NUMBER, &bus) < 0) {
         fprintf(stderr, "%s is not a SCSI device\n", device);
         close(dev->fd);
-        free(dev);
-        return NULL;
+        dev->fd = -1;
+        return -1;
     }
 
     // Get device info
@@ -157,7 +237,9 @@ IT8951_USB* it8951_usb_open(const char *device) {
         0x80, 0x00,              // Get System Info
         0x01, 0x00, 0x02, 0x00   // Version
     };
-    unsigned char deviceinfo_result[112];
+    // Sized to the struct it is read through; the command itself returns
+    // 112 bytes (the trailing command_table pointer is not wire format)
+    unsigned char deviceinfo_result[sizeof(IT8951_deviceinfo)];
 
     sg_io_hdr_t io_hdr;
     memset(&io_hdr, 0, sizeof(sg_io_hdr_t));
@@ -172,14 +254,176 @@ IT8951_USB* it8951_usb_open(const char *device) {
     if (ioctl(dev->fd, SG_IO, &io_hdr) < 0) {
         perror("Failed to get device info");
         close(dev->fd);
-        free(dev);
-        return NULL;
+        dev->fd = -1;
+        return -1;
     }
 
     IT8951_deviceinfo *info = (IT8951_deviceinfo *)deviceinfo_result;
     dev->width = __bswap_32(info->width);
     dev->height = __bswap_32(info->height);
     dev->img_addr = info->image_buffer_addr;
+    dev->upd_addr = info->update_buffer_addr;
+    return 0;
+}
+
+// Repaint the panel from the retained framebuffer after a reconnect, so
+// an interrupted frame doesn't stay half-painted. Single-attempt sends:
+// if the link is still bad the next caller's retry handles it.
+static void replay_shadow(IT8951_USB *dev) {
+    if (!dev->shadow || !dev->shadow_valid) return;
+
+    int w = dev->width, h = dev->height;
+    int lines = dev->chunk_size / w;
+    int y = 0;
+    while (y < h) {
+        int chunk_lines = lines;
+        if (y + chunk_lines > h) chunk_lines = h - y;
+        if (load_image_area_once(dev, dev->img_addr, 0, y, w, chunk_lines,
+                                 dev->shadow + (size_t)y * w,
+                                 chunk_lines * w) != 0) {
+            return;
+        }
+        y += chunk_lines;
+    }
+    display_area_once(dev, dev->img_addr, 0, 0, w, h, MODE_GC16);
+}
+
+// The handle is dead (retries exhausted): re-open and re-handshake the
+// device with backoff, then repaint from the shadow. Serialized because
+// the async pipeline can fail on two threads at once; the loser just
+// re-handshakes a healthy handle, which is harmless.
+static int recover(IT8951_USB *dev) {
+    static const int backoff_ms[] = { 50, 100, 200 };
+
+    pthread_mutex_lock(&dev->recover_lock);
+    if (dev->fd >= 0) close(dev->fd);
+    dev->fd = -1;
+
+    for (unsigned int i = 0; i < sizeof(backoff_ms) / sizeof(backoff_ms[0]); i++) {
+        usleep(backoff_ms[i] * 1000);
+        if (device_handshake(dev, dev->devpath) == 0) {
+            dev->stats.reopens++;
+            dev->use_iovec = 1;    // Re-probe the fresh handle
+            dev->use_sg_async = 1;
+            dev->cur_addr = dev->img_addr;
+            dev->front_addr = dev->upd_addr;
+            replay_shadow(dev);
+            pthread_mutex_unlock(&dev->recover_lock);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&dev->recover_lock);
+    return -1;
+}
+
+// Retrying wrappers: transient failures back off and retry in place; a
+// handle that stays dead goes through the re-open handshake once, then
+// the command gets a final attempt. Unattended units self-heal in
+// hundreds of milliseconds instead of wedging half-painted.
+static int load_image_area(IT8951_USB *dev, unsigned int addr, int x, int y,
+                           int w, int h, uint8_t *data, int length) {
+    trace_begin("usb_chunk");
+    int backoff_us = 10000;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (load_image_area_once(dev, addr, x, y, w, h, data, length) == 0) {
+            trace_end("usb_chunk");
+            return 0;
+        }
+        dev->stats.retries++;
+        usleep(backoff_us);
+        backoff_us *= 4;  // 10ms, 40ms, 160ms
+    }
+    int ret = -1;
+    if (recover(dev) == 0) {
+        ret = load_image_area_once(dev, addr, x, y, w, h, data, length);
+    }
+    trace_end("usb_chunk");
+    return ret;
+}
+
+static int display_area(IT8951_USB *dev, unsigned int addr, int x, int y,
+                        int w, int h, int mode) {
+    trace_begin("refresh");
+    int backoff_us = 10000;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (display_area_once(dev, addr, x, y, w, h, mode) == 0) {
+            trace_end("refresh");
+            return 0;
+        }
+        dev->stats.retries++;
+        usleep(backoff_us);
+        backoff_us *= 4;
+    }
+    int ret = -1;
+    if (recover(dev) == 0) {
+        ret = display_area_once(dev, addr, x, y, w, h, mode);
+    }
+    trace_end("refresh");
+    return ret;
+}
+
+IT8951_USB* it8951_usb_open(const char *device) {
+    IT8951_USB *dev = malloc(sizeof(IT8951_USB));
+    if (!dev) return NULL;
+
+    if (device_handshake(dev, device) < 0) {
+        free(dev);
+        return NULL;
+    }
+    snprintf(dev->devpath, sizeof(dev->devpath), "%s", device);
+    pthread_mutex_init(&dev->recover_lock, NULL);
+
+    // Shadow copy of what the panel currently shows, for differential updates
+    dev->shadow = malloc((size_t)dev->width * dev->height);
+    dev->shadow_valid = 0;
+
+    // Pre-allocated transfer buffer reused by every load_image_area chunk;
+    // the area header lives up front so payloads can be staged in place
+    dev->xfer_buf = malloc(MAX_TRANSFER + 32);
+    if (!dev->xfer_buf) {
+        close(dev->fd);
+        free(dev->shadow);
+        free(dev);
+        return NULL;
+    }
+
+    // Assume scatter-gather works until the first transfer says otherwise
+    dev->use_iovec = 1;
+    dev->pixel_format = IT8951_FMT_8BPP;
+    dev->chunk_size = MAX_TRANSFER;
+    dev->timeout_ms = IT8951_USB_TIMEOUT;
+    dev->dither = IT8951_DITHER_NONE;
+    dev->dither_buf = NULL;
+    memset(dev->tile_a2, 0, sizeof(dev->tile_a2));
+    dev->last_update_ns = 0;
+    dev->policy = (IT8951_refresh_policy){ .max_a2_updates = 8,
+                                           .idle_ms = 300,
+                                           .tiles_per_pass = 4 };
+    it8951_reset_stats(dev);
+
+    // Async pipeline starts lazily on first it8951_display_async()
+    dev->batching = 0;
+    dev->batch_count = 0;
+    // Assume the sg driver queues commands until the first write() fails
+    dev->use_sg_async = 1;
+    dev->batch_buf = NULL;
+
+    dev->async_started = 0;
+    dev->async_pending = 0;
+    dev->async_quit = 0;
+    dev->cur_addr = dev->img_addr;
+    dev->front_addr = dev->upd_addr;
+    // Extra regions start past the two frame buffers. Addresses are kept in
+    // the little-endian byte order the load/display commands expect, which
+    // is host order on the Pi, so plain arithmetic is fine.
+    {
+        unsigned int fb_bytes = (unsigned int)dev->width * dev->height;
+        unsigned int top = (dev->img_addr > dev->upd_addr ? dev->img_addr
+                                                          : dev->upd_addr) + fb_bytes;
+        dev->alloc_next = (top + 4095u) & ~4095u;
+    }
+    pthread_mutex_init(&dev->async_lock, NULL);
+    pthread_cond_init(&dev->async_cond, NULL);
 
     printf("IT8951 USB: %dx%d, buffer addr=0x%08x\n", dev->width, dev->height, dev->img_addr);
 
@@ -188,52 +432,847 @@ IT8951_USB* it8951_usb_open(const char *device) {
 
 void it8951_usb_close(IT8951_USB *dev) {
     if (dev) {
+        if (dev->async_started) {
+            it8951_wait(dev);
+            pthread_mutex_lock(&dev->async_lock);
+            dev->async_quit = 1;
+            pthread_cond_broadcast(&dev->async_cond);
+            pthread_mutex_unlock(&dev->async_lock);
+            pthread_join(dev->refresh_thread, NULL);
+        }
         close(dev->fd);
+        free(dev->shadow);
+        free(dev->xfer_buf);
+        free(dev->dither_buf);
+        free(dev->batch_buf);
         free(dev);
     }
 }
 
 int it8951_clear(IT8951_USB *dev, int mode) {
-    int size = dev->width * dev->height;
-    uint8_t *buf = malloc(size);
-    if (!buf) return -1;
+    it8951_wait(dev);  // Don't race a queued async refresh
 
-    memset(buf, 0xFF, size);  // White
-
-    // Send in chunks
     int w = dev->width;
     int h = dev->height;
-    int lines = MAX_TRANSFER / w;
-    int offset = 0;
+    int lines = dev->chunk_size / w;
+
+    // One chunk of constant white, staged where load_image_area() keeps
+    // its payloads so the fallback path skips the copy - no reason to
+    // materialize a full white frame just to send it in slices
+    uint8_t *white = dev->xfer_buf + sizeof(IT8951_area);
+    memset(white, 0xFF, (size_t)lines * w);
 
-    while (offset < size) {
+    int ret = 0;
+    int y = 0;
+    while (y < h) {
         int chunk_lines = lines;
-        if ((offset / w) + chunk_lines > h) {
-            chunk_lines = h - (offset / w);
-        }
-        load_image_area(dev, 0, offset / w, w, chunk_lines, buf + offset);
-        offset += chunk_lines * w;
+        if (y + chunk_lines > h) chunk_lines = h - y;
+        ret |= load_image_area(dev, dev->img_addr, 0, y, w, chunk_lines,
+                               white, chunk_lines * w);
+        y += chunk_lines;
     }
 
-    int ret = display_area(dev, 0, 0, w, h, mode);
-    free(buf);
+    ret |= display_area(dev, dev->img_addr, 0, 0, w, h, mode);
+
+    if (dev->shadow) {
+        memset(dev->shadow, 0xFF, (size_t)w * h);
+        dev->shadow_valid = 1;
+    }
     return ret;
 }
 
+// Mirror a region of the outgoing frame into the shadow framebuffer
+static void shadow_update(IT8951_USB *dev, uint8_t *image, int x, int y, int w, int h) {
+    if (!dev->shadow) return;
+    // Redisplaying the shadow itself (refresh scheduler) is a no-op here
+    if (image == dev->shadow + (size_t)y * dev->width + x && w == dev->width) return;
+    for (int row = 0; row < h; row++) {
+        memcpy(dev->shadow + (size_t)(y + row) * dev->width + x,
+               image + (size_t)row * w, w);
+    }
+    if (x == 0 && y == 0 && w == dev->width && h == dev->height) {
+        dev->shadow_valid = 1;
+    }
+}
+
+// Resolve MODE_AUTO from frame content: a histogram census classes the
+// pixels, and under 2% midtones the frame is treated as bilevel - the
+// fast DU waveform shows it faithfully at a fraction of GC16's refresh
+// time. The census is one linear NEON pass, well under a chunk's USB time.
+static int resolve_mode(const uint8_t *image, int w, int h, int mode) {
+    if (mode != MODE_AUTO) return mode;
+
+    uint64_t tones[3];
+    imgproc_tone_stats(image, (size_t)w * h, tones);
+    uint64_t total = tones[0] + tones[1] + tones[2];
+    return (tones[1] * 50 < total) ? MODE_DU : MODE_GC16;
+}
+
+int it8951_upload(IT8951_USB *dev, uint8_t *image, int x, int y, int w, int h) {
+    it8951_wait(dev);
+
+    int lines = dev->chunk_size / w;
+    int row = 0;
+    int ret = 0;
+
+    while (row < h) {
+        int chunk_lines = lines;
+        if (row + chunk_lines > h) chunk_lines = h - row;
+        ret |= load_image_area(dev, dev->img_addr, x, y + row, w, chunk_lines,
+                               image + (size_t)row * w, chunk_lines * w);
+        row += chunk_lines;
+    }
+
+    shadow_update(dev, image, x, y, w, h);
+    return ret;
+}
+
+int it8951_refresh(IT8951_USB *dev, int x, int y, int w, int h, int mode) {
+    // The pixels already went up; the shadow holds what will be shown
+    if (mode == MODE_AUTO && dev->shadow) {
+        mode = resolve_mode(dev->shadow, dev->width, dev->height, mode);
+    } else if (mode == MODE_AUTO) {
+        mode = MODE_GC16;
+    }
+    return display_area(dev, dev->img_addr, x, y, w, h, mode);
+}
+
+// Run the configured dither stage if it applies to this waveform mode.
+// Returns the buffer to transfer (the original image when not dithering).
+static uint8_t* dither_stage(IT8951_USB *dev, uint8_t *image, int w, int h, int mode) {
+    if (dev->dither == IT8951_DITHER_NONE) return image;
+    if (mode != MODE_A2 && mode != MODE_DU) return image;
+
+    if (!dev->dither_buf) {
+        dev->dither_buf = malloc((size_t)dev->width * dev->height);
+        if (!dev->dither_buf) return image;
+    }
+    if (dev->dither == IT8951_DITHER_FS) {
+        imgproc_dither_fs(image, dev->dither_buf, w, h);
+    } else {
+        imgproc_dither_ordered(image, dev->dither_buf, w, h);
+    }
+    return dev->dither_buf;
+}
+
 int it8951_display(IT8951_USB *dev, uint8_t *image, int x, int y, int w, int h, int mode) {
-    // Send image in chunks (MAX_TRANSFER limit)
-    int lines = MAX_TRANSFER / w;
-    int offset = 0;
-    int size = w * h;
+    it8951_wait(dev);  // Don't race a queued async refresh
+
+    mode = resolve_mode(image, w, h, mode);
+    image = dither_stage(dev, image, w, h, mode);
+
+    // Pixels per transferred byte for the configured format; packed formats
+    // need the row width to divide evenly, otherwise fall back to 8bpp
+    int ppb = 1;
+    if (dev->pixel_format == IT8951_FMT_4BPP && (w % 2) == 0) ppb = 2;
+    else if (dev->pixel_format == IT8951_FMT_1BPP && (w % 8) == 0) ppb = 8;
+
+    // Send image in chunks (MAX_TRANSFER limit); packed formats fit
+    // proportionally more lines per transfer
+    int row_bytes = w / ppb;
+    int lines = dev->chunk_size / row_bytes;
+    int row = 0;
+
+    while (row < h) {
+        int chunk_lines = lines;
+        if (row + chunk_lines > h) chunk_lines = h - row;
+
+        uint8_t *src = image + (size_t)row * w;
+        if (ppb == 1) {
+            load_image_area(dev, dev->img_addr, x, y + row, w, chunk_lines,
+                            src, chunk_lines * w);
+        } else {
+            // Pack straight into the transfer buffer behind the header so
+            // the fallback path skips its payload copy
+            uint8_t *packed = dev->xfer_buf + sizeof(IT8951_area);
+            if (ppb == 2) imgproc_pack_4bpp(src, packed, chunk_lines * w);
+            else          imgproc_pack_1bpp(src, packed, chunk_lines * w);
+            load_image_area(dev, dev->img_addr, x, y + row, w, chunk_lines,
+                            packed, chunk_lines * row_bytes);
+        }
+        row += chunk_lines;
+    }
+
+    shadow_update(dev, image, x, y, w, h);
+    return display_area(dev, dev->img_addr, x, y, w, h, mode);
+}
+
+int it8951_set_pixel_format(IT8951_USB *dev, int fmt) {
+    if (fmt != IT8951_FMT_8BPP && fmt != IT8951_FMT_4BPP && fmt != IT8951_FMT_1BPP) {
+        return -1;
+    }
+    dev->pixel_format = fmt;
+    return 0;
+}
+
+// Find the changed span of a row against the shadow, 8 bytes at a time.
+// Returns 0 if the row is identical, else sets [*x0, *x1).
+static int row_diff_span(const uint8_t *new_row, const uint8_t *old_row, int w,
+                         int *x0, int *x1) {
+    if (memcmp(new_row, old_row, w) == 0) return 0;
 
-    while (offset < size) {
+    const uint64_t *nw = (const uint64_t *)new_row;
+    const uint64_t *ow = (const uint64_t *)old_row;
+    int words = w / 8;
+
+    int lo = 0;
+    while (lo < words && nw[lo] == ow[lo]) lo++;
+    int hi = words;
+    while (hi > lo && nw[hi - 1] == ow[hi - 1]) hi--;
+
+    int start = lo * 8;
+    int end = hi * 8;
+    // Tail bytes that don't fill a word
+    for (int i = words * 8; i < w; i++) {
+        if (new_row[i] != old_row[i]) {
+            if (start > i) start = i;
+            if (end < i + 1) end = i + 1;
+        }
+    }
+    *x0 = start;
+    *x1 = end;
+    return 1;
+}
+
+// Send a sub-rectangle of a full-width frame, gathering rows per chunk.
+// Honors the configured packed pixel format when the rectangle's x/w
+// alignment allows it (the diff engine aligns its bands to 8 pixels, so
+// sprite-scale A2 updates ship 8 pixels per byte at 1bpp).
+static int send_rect(IT8951_USB *dev, uint8_t *image, int x, int y, int w, int h, int mode) {
+    int stride = dev->width;
+    if (x == 0 && w == stride) {
+        return it8951_display(dev, image + (size_t)y * stride, x, y, w, h, mode);
+    }
+
+    int ppb = 1;
+    if (dev->pixel_format == IT8951_FMT_4BPP && (x % 2) == 0 && (w % 2) == 0) {
+        ppb = 2;
+    } else if (dev->pixel_format == IT8951_FMT_1BPP && (x % 8) == 0 && (w % 8) == 0) {
+        ppb = 8;
+    }
+
+    static uint8_t scratch[MAX_TRANSFER];
+    int row_bytes = w / ppb;
+    int lines = dev->chunk_size / row_bytes;
+    int row = 0;
+
+    while (row < h) {
         int chunk_lines = lines;
-        if ((offset / w) + chunk_lines > h) {
-            chunk_lines = h - (offset / w);
+        if (row + chunk_lines > h) chunk_lines = h - row;
+        for (int i = 0; i < chunk_lines; i++) {
+            uint8_t *src = image + (size_t)(y + row + i) * stride + x;
+            uint8_t *dst = scratch + (size_t)i * row_bytes;
+            if (ppb == 1)      memcpy(dst, src, w);
+            else if (ppb == 2) imgproc_pack_4bpp(src, dst, w);
+            else               imgproc_pack_1bpp(src, dst, w);
+        }
+        load_image_area(dev, dev->img_addr, x, y + row, w, chunk_lines,
+                        scratch, chunk_lines * row_bytes);
+        row += chunk_lines;
+    }
+
+    // Open survives a failed shadow malloc (low-memory units), so the
+    // mirror has to be conditional like everywhere else
+    if (dev->shadow && image != dev->shadow) {
+        for (int i = 0; i < h; i++) {
+            memcpy(dev->shadow + (size_t)(y + i) * stride + x,
+                   image + (size_t)(y + i) * stride + x, w);
         }
-        load_image_area(dev, x, y + (offset / w), w, chunk_lines, image + offset);
-        offset += chunk_lines * w;
     }
+    return display_area(dev, dev->img_addr, x, y, w, h, mode);
+}
+
+int it8951_display_diff(IT8951_USB *dev, uint8_t *image, int mode) {
+    it8951_wait(dev);  // Don't race a queued async refresh
+
+    int w = dev->width;
+    int h = dev->height;
+
+    mode = resolve_mode(image, w, h, mode);
+
+    // Dither before diffing so the shadow compare sees what the panel gets;
+    // dithered static regions stay byte-identical frame to frame
+    image = dither_stage(dev, image, w, h, mode);
+
+    // No baseline yet (or no shadow memory): push the whole frame
+    if (!dev->shadow || !dev->shadow_valid) {
+        return it8951_display(dev, image, 0, 0, w, h, mode);
+    }
+
+    // Scan rows, merging runs of dirty rows into bands. Rows separated by a
+    // small clean gap are merged so we don't pay a display_area per scanline.
+    const int row_gap = 4;
+    int ret = 0;
+    int band_y = -1, band_h = 0, band_x0 = 0, band_x1 = 0, gap = 0;
+
+    for (int y = 0; y <= h; y++) {
+        int x0 = 0, x1 = 0;
+        int dirty = (y < h) && row_diff_span(image + (size_t)y * w,
+                                            dev->shadow + (size_t)y * w, w,
+                                            &x0, &x1);
+        if (dirty) {
+            if (band_y < 0) {
+                band_y = y;
+                band_h = 1;
+                band_x0 = x0;
+                band_x1 = x1;
+            } else {
+                band_h = y - band_y + 1;
+                if (x0 < band_x0) band_x0 = x0;
+                if (x1 > band_x1) band_x1 = x1;
+            }
+            gap = 0;
+        } else if (band_y >= 0 && (++gap > row_gap || y == h)) {
+            // Flush band; align x to 8 pixels for the controller
+            int rx = band_x0 & ~7;
+            int rw = ((band_x1 + 7) & ~7) - rx;
+            if (rx + rw > w) rw = w - rx;
+            ret |= send_rect(dev, image, rx, band_y, rw, band_h, mode);
+            band_y = -1;
+        }
+    }
+
+    return ret;
+}
+
+int it8951_display_a2(IT8951_USB *dev, uint8_t *image) {
+    // The diff engine skips every row the sprite didn't touch and aligns
+    // its bands to 8 pixels, which is exactly what the 1bpp packed path
+    // in send_rect() needs - so with IT8951_FMT_1BPP configured, a
+    // moving sprite costs tens of KB per frame instead of a full frame.
+    return it8951_display_diff(dev, image, MODE_A2);
+}
 
-    return display_area(dev, x, y, w, h, mode);
+// Worker: waits out the panel's waveform refresh so the caller's thread is
+// free to upload the next frame to the other device buffer meanwhile
+static void *refresh_worker(void *arg) {
+    IT8951_USB *dev = (IT8951_USB *)arg;
+
+    pthread_mutex_lock(&dev->async_lock);
+    while (1) {
+        while (!dev->async_pending && !dev->async_quit) {
+            pthread_cond_wait(&dev->async_cond, &dev->async_lock);
+        }
+        if (dev->async_quit) break;
+
+        unsigned int addr = dev->pending_addr;
+        int x = dev->pending_x, y = dev->pending_y;
+        int w = dev->pending_w, h = dev->pending_h;
+        int mode = dev->pending_mode;
+
+        pthread_mutex_unlock(&dev->async_lock);
+        display_area(dev, addr, x, y, w, h, mode);
+        pthread_mutex_lock(&dev->async_lock);
+
+        dev->async_pending = 0;
+        pthread_cond_broadcast(&dev->async_cond);
+    }
+    pthread_mutex_unlock(&dev->async_lock);
+    return NULL;
+}
+
+void it8951_wait(IT8951_USB *dev) {
+    if (!dev->async_started) return;
+    trace_begin("refresh_wait");
+    pthread_mutex_lock(&dev->async_lock);
+    while (dev->async_pending) {
+        pthread_cond_wait(&dev->async_cond, &dev->async_lock);
+    }
+    pthread_mutex_unlock(&dev->async_lock);
+    trace_end("refresh_wait");
+}
+
+int it8951_display_async(IT8951_USB *dev, uint8_t *image, int mode) {
+    int w = dev->width;
+    int h = dev->height;
+
+    mode = resolve_mode(image, w, h, mode);
+    image = dither_stage(dev, image, w, h, mode);
+
+    if (!dev->async_started) {
+        if (pthread_create(&dev->refresh_thread, NULL, refresh_worker, dev) != 0) {
+            // No worker: degrade to the synchronous path
+            return it8951_display(dev, image, 0, 0, w, h, mode);
+        }
+        dev->async_started = 1;
+    }
+
+    // Upload to the idle buffer while the previous refresh is still running.
+    // The iovec path reads straight from the caller's buffer; the fallback
+    // path only touches xfer_buf, which the worker never uses.
+    int lines = dev->chunk_size / w;
+    unsigned int addr = dev->cur_addr;
+    int row = 0;
+
+    while (row < h) {
+        int chunk_lines = lines;
+        if (row + chunk_lines > h) chunk_lines = h - row;
+        load_image_area(dev, addr, 0, row, w, chunk_lines,
+                        image + (size_t)row * w, chunk_lines * w);
+        row += chunk_lines;
+    }
+
+    shadow_update(dev, image, 0, 0, w, h);
+
+    // Hand the refresh to the worker and flip to the other device buffer
+    pthread_mutex_lock(&dev->async_lock);
+    while (dev->async_pending) {
+        pthread_cond_wait(&dev->async_cond, &dev->async_lock);
+    }
+    dev->pending_addr = addr;
+    dev->pending_x = 0;
+    dev->pending_y = 0;
+    dev->pending_w = w;
+    dev->pending_h = h;
+    dev->pending_mode = mode;
+    dev->async_pending = 1;
+    pthread_cond_broadcast(&dev->async_cond);
+    pthread_mutex_unlock(&dev->async_lock);
+
+    it8951_buffer_flip(dev);
+    return 0;
+}
+
+unsigned int it8951_buffer_back(IT8951_USB *dev) {
+    return dev->cur_addr;
+}
+
+unsigned int it8951_buffer_front(IT8951_USB *dev) {
+    return dev->front_addr;
+}
+
+void it8951_buffer_flip(IT8951_USB *dev) {
+    unsigned int tmp = dev->cur_addr;
+    dev->cur_addr = dev->front_addr;
+    dev->front_addr = tmp;
+}
+
+unsigned int it8951_alloc_region(IT8951_USB *dev, int bytes) {
+    if (bytes <= 0) return 0;
+
+    // The controller doesn't report its RAM size; stay within the 16 MB
+    // window that every IT8951 board we ship carries at minimum
+    unsigned int limit = 16u * 1024 * 1024;
+    unsigned int aligned = ((unsigned int)bytes + 4095u) & ~4095u;
+    if (dev->alloc_next + aligned > limit) return 0;
+
+    unsigned int addr = dev->alloc_next;
+    dev->alloc_next += aligned;
+    return addr;
+}
+
+
+// Member-wise so each counter is read/cleared atomically (a whole-struct
+// copy would bypass the atomics); the snapshot itself is not a single
+// consistent instant, which is fine for throughput counters
+void it8951_get_stats(IT8951_USB *dev, IT8951_stats *out) {
+    out->sgio_calls = dev->stats.sgio_calls;
+    out->bytes_sent = dev->stats.bytes_sent;
+    out->load_ns = dev->stats.load_ns;
+    out->display_ns = dev->stats.display_ns;
+    out->refreshes = dev->stats.refreshes;
+    out->retries = dev->stats.retries;
+    out->reopens = dev->stats.reopens;
+}
+
+void it8951_reset_stats(IT8951_USB *dev) {
+    dev->stats.sgio_calls = 0;
+    dev->stats.bytes_sent = 0;
+    dev->stats.load_ns = 0;
+    dev->stats.display_ns = 0;
+    dev->stats.refreshes = 0;
+    dev->stats.retries = 0;
+    dev->stats.reopens = 0;
+}
+
+void it8951_set_chunk_size(IT8951_USB *dev, int bytes) {
+    if (bytes < MIN_CHUNK) bytes = MIN_CHUNK;
+    if (bytes > MAX_TRANSFER) bytes = MAX_TRANSFER;
+    dev->chunk_size = bytes;
+}
+
+int it8951_calibrate(IT8951_USB *dev, IT8951_tune_point *out, int max_points) {
+    static const int sizes[] = { 8192, 16384, 32768, MAX_TRANSFER };
+    const int n_sizes = (int)(sizeof(sizes) / sizeof(sizes[0]));
+    const int probe_bytes = 1 << 20;  // 1 MB per size averages out USB jitter
+
+    if (out) {
+        for (int i = 0; i < max_points; i++) {
+            out[i].chunk_size = 0;
+            out[i].mb_per_s = 0.0;
+        }
+    }
+
+    it8951_wait(dev);
+
+    // Probes go to the idle (back) device buffer: nothing the panel can
+    // re-display lives there, and the next real upload overwrites it
+    unsigned int addr = dev->cur_addr;
+    uint8_t *payload = dev->xfer_buf + sizeof(IT8951_area);
+    memset(payload, 0xAA, MAX_TRANSFER);
+
+    int w = dev->width;
+    int best = -1;
+    double best_rate = 0.0;
+
+    for (int i = 0; i < n_sizes; i++) {
+        int lines = sizes[i] / w;
+        if (lines < 1) lines = 1;
+        int per_xfer = lines * w;
+        int reps = probe_bytes / per_xfer + 1;
+
+        // Wrap so the probe's last row still lands on the panel; a naive
+        // % height lets the rectangle spill past the probed buffer into
+        // whatever device region follows it
+        int y_span = dev->height - lines + 1;
+        if (y_span < 1) y_span = 1;
+
+        uint64_t t0 = now_ns();
+        int failed = 0;
+        for (int r = 0; r < reps && !failed; r++) {
+            failed = load_image_area(dev, addr, 0, (r * lines) % y_span,
+                                     w, lines, payload, per_xfer) != 0;
+        }
+        if (failed) continue;
+
+        double secs = (double)(now_ns() - t0) / 1e9;
+        double rate = ((double)reps * per_xfer) / (1024.0 * 1024.0) / secs;
+        if (out && i < max_points) {
+            out[i].chunk_size = sizes[i];
+            out[i].mb_per_s = rate;
+        }
+        if (rate > best_rate) {
+            best_rate = rate;
+            best = sizes[i];
+        }
+    }
+    if (best < 0) return -1;
+
+    it8951_set_chunk_size(dev, best);
+
+    // Derive the command timeout from what the bus actually does: a full
+    // chunk at the measured rate, with a generous 50x margin for hub
+    // contention, clamped so hangs still fail within a sane window
+    double chunk_ms = (double)MAX_TRANSFER / (best_rate * 1024.0 * 1024.0) * 1000.0;
+    int timeout = (int)(chunk_ms * 50.0);
+    if (timeout < 2000) timeout = 2000;
+    if (timeout > IT8951_USB_TIMEOUT) timeout = IT8951_USB_TIMEOUT;
+    dev->timeout_ms = timeout;
+
+    return best;
+}
+
+// Clip a rectangle to panel bounds and align x/w to 8 pixels.
+// Returns 0 if nothing is left after clipping.
+static int clip_rect(IT8951_USB *dev, IT8951_rect *r) {
+    int x1 = r->x + r->w;
+    int y1 = r->y + r->h;
+    if (r->x < 0) r->x = 0;
+    if (r->y < 0) r->y = 0;
+    if (x1 > dev->width) x1 = dev->width;
+    if (y1 > dev->height) y1 = dev->height;
+    if (x1 <= r->x || y1 <= r->y) return 0;
+
+    r->x &= ~7;
+    x1 = (x1 + 7) & ~7;
+    if (x1 > dev->width) x1 = dev->width;
+    r->w = x1 - r->x;
+    r->h = y1 - r->y;
+    return 1;
+}
+
+int it8951_display_region(IT8951_USB *dev, uint8_t *frame,
+                          int x, int y, int w, int h, int mode) {
+    IT8951_rect r = { x, y, w, h };
+    if (!clip_rect(dev, &r)) return 0;
+
+    mode = resolve_mode(frame, dev->width, dev->height, mode);
+    it8951_wait(dev);
+    return send_rect(dev, frame, r.x, r.y, r.w, r.h, mode);
+}
+
+// Merging two rects is worth it when the union's bounding box doesn't
+// transfer much more than the rects separately - one SG_IO sequence and
+// one refresh beat two of each
+static int should_merge(const IT8951_rect *a, const IT8951_rect *b) {
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = (a->x + a->w > b->x + b->w) ? a->x + a->w : b->x + b->w;
+    int y1 = (a->y + a->h > b->y + b->h) ? a->y + a->h : b->y + b->h;
+    long box = (long)(x1 - x0) * (y1 - y0);
+    long sum = (long)a->w * a->h + (long)b->w * b->h;
+    return box <= sum + sum / 2;
+}
+
+// Coalesce pairwise until stable; returns the new count
+static int coalesce_rects(IT8951_rect *list, int count) {
+    int merged = 1;
+    while (merged) {
+        merged = 0;
+        for (int i = 0; i < count && !merged; i++) {
+            for (int j = i + 1; j < count && !merged; j++) {
+                if (should_merge(&list[i], &list[j])) {
+                    int x0 = list[i].x < list[j].x ? list[i].x : list[j].x;
+                    int y0 = list[i].y < list[j].y ? list[i].y : list[j].y;
+                    int x1 = list[i].x + list[i].w > list[j].x + list[j].w ?
+                             list[i].x + list[i].w : list[j].x + list[j].w;
+                    int y1 = list[i].y + list[i].h > list[j].y + list[j].h ?
+                             list[i].y + list[i].h : list[j].y + list[j].h;
+                    list[i] = (IT8951_rect){ x0, y0, x1 - x0, y1 - y0 };
+                    list[j] = list[count - 1];
+                    count--;
+                    merged = 1;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+int it8951_display_rects(IT8951_USB *dev, uint8_t *frame,
+                         const IT8951_rect *rects, int n, int mode) {
+    IT8951_rect list[IT8951_BATCH_MAX];
+    int count = 0;
+
+    for (int i = 0; i < n && count < IT8951_BATCH_MAX; i++) {
+        IT8951_rect r = rects[i];
+        if (clip_rect(dev, &r)) list[count++] = r;
+    }
+    if (count == 0) return 0;
+
+    count = coalesce_rects(list, count);
+
+    mode = resolve_mode(frame, dev->width, dev->height, mode);
+    it8951_wait(dev);
+    int ret = 0;
+    for (int i = 0; i < count; i++) {
+        ret |= send_rect(dev, frame, list[i].x, list[i].y,
+                         list[i].w, list[i].h, mode);
+    }
+    return ret;
+}
+
+// ---- Batched submission ----
+//
+// The sg driver also queues commands through its write()/read()
+// interface: write() enqueues an sg_io_hdr and returns without waiting
+// for the device, read() reaps one completion. Keeping a window of load
+// chunks in flight turns a frame's worth of blocking SG_IO round trips
+// into a pipelined stream with a few reap syscalls at the tail. Each
+// slot gets its own staging buffer so out-of-order completion can never
+// hand the device a buffer we're refilling.
+
+#define SG_ASYNC_WINDOW 8
+#define BATCH_SLOT (MAX_TRANSFER + sizeof(IT8951_area))
+
+// Reap one queued command and return its status
+static int batch_reap(IT8951_USB *dev) {
+    struct pollfd pfd = { dev->fd, POLLIN, 0 };
+    if (poll(&pfd, 1, dev->timeout_ms) <= 0) return -1;
+
+    sg_io_hdr_t done;
+    if (read(dev->fd, &done, sizeof(done)) != sizeof(done)) return -1;
+    return (done.status || done.host_status || done.driver_status) ? -1 : 0;
+}
+
+// Queue the load command staged in slot (area header already in place).
+// Returns -1 when the sg driver won't take the queued write.
+static int batch_queue(IT8951_USB *dev, uint8_t *slot, int length) {
+    unsigned char cmd[16] = {
+        0xfe, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xa2, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00
+    };
+
+    sg_io_hdr_t io_hdr;
+    memset(&io_hdr, 0, sizeof(sg_io_hdr_t));
+    io_hdr.interface_id = 'S';
+    io_hdr.cmd_len = 16;
+    io_hdr.dxfer_direction = SG_DXFER_TO_DEV;
+    io_hdr.dxfer_len = length + sizeof(IT8951_area);
+    io_hdr.dxferp = slot;
+    io_hdr.cmdp = cmd;
+    io_hdr.timeout = dev->timeout_ms;
+
+    if (write(dev->fd, &io_hdr, sizeof(io_hdr)) != sizeof(io_hdr)) return -1;
+    dev->stats.sgio_calls++;
+    dev->stats.bytes_sent += length;
+    return 0;
+}
+
+int it8951_batch_begin(IT8951_USB *dev) {
+    dev->batch_count = 0;
+    dev->batching = 1;
+    return 0;
+}
+
+int it8951_batch_add_rect(IT8951_USB *dev, int x, int y, int w, int h) {
+    if (!dev->batching) return -1;
+    IT8951_rect r = { x, y, w, h };
+    if (!clip_rect(dev, &r)) return 0;  // Nothing on-panel: not an error
+    if (dev->batch_count >= IT8951_BATCH_MAX) return -1;
+    dev->batch[dev->batch_count++] = r;
+    return 0;
+}
+
+int it8951_batch_submit(IT8951_USB *dev, uint8_t *frame, int mode) {
+    if (!dev->batching) return -1;
+    dev->batching = 0;
+
+    int count = coalesce_rects(dev->batch, dev->batch_count);
+    dev->batch_count = 0;
+    if (count == 0) return 0;
+
+    mode = resolve_mode(frame, dev->width, dev->height, mode);
+    it8951_wait(dev);
+
+    if (dev->use_sg_async && !dev->batch_buf) {
+        dev->batch_buf = malloc((size_t)SG_ASYNC_WINDOW * BATCH_SLOT);
+        if (!dev->batch_buf) dev->use_sg_async = 0;
+    }
+
+    int stride = dev->width;
+    int ret = 0;
+    int inflight = 0;
+    int slot = 0;
+    int sync_from = count;  // First rect that fell back to send_rect()
+    uint64_t t0 = now_ns();
+
+    for (int i = 0; i < count; i++) {
+        IT8951_rect *r = &dev->batch[i];
+
+        if (!dev->use_sg_async) {
+            if (sync_from > i) sync_from = i;
+            ret |= send_rect(dev, frame, r->x, r->y, r->w, r->h, mode);
+            continue;
+        }
+
+        int lines = dev->chunk_size / r->w;
+        int row = 0;
+        while (row < r->h) {
+            int chunk_lines = lines;
+            if (row + chunk_lines > r->h) chunk_lines = r->h - row;
+
+            if (inflight == SG_ASYNC_WINDOW) {
+                ret |= batch_reap(dev);
+                inflight--;
+            }
+
+            // Stage header + gathered rows in the next free slot
+            uint8_t *buf = dev->batch_buf + (size_t)slot * BATCH_SLOT;
+            IT8951_area area;
+            memset(&area, 0, sizeof(IT8951_area));
+            area.address = dev->img_addr;
+            area.x = __bswap_32(r->x);
+            area.y = __bswap_32(r->y + row);
+            area.w = __bswap_32(r->w);
+            area.h = __bswap_32(chunk_lines);
+            memcpy(buf, &area, sizeof(IT8951_area));
+            for (int l = 0; l < chunk_lines; l++) {
+                memcpy(buf + sizeof(IT8951_area) + (size_t)l * r->w,
+                       frame + (size_t)(r->y + row + l) * stride + r->x, r->w);
+            }
+
+            if (batch_queue(dev, buf, chunk_lines * r->w) < 0) {
+                // Driver refused queued writes: drain, drop to sync for good
+                while (inflight > 0) { ret |= batch_reap(dev); inflight--; }
+                dev->use_sg_async = 0;
+                break;
+            }
+            inflight++;
+            slot = (slot + 1) % SG_ASYNC_WINDOW;
+            row += chunk_lines;
+        }
+
+        if (!dev->use_sg_async) {
+            // Redo this rect synchronously (re-sent chunks are harmless)
+            sync_from = i;
+            ret |= send_rect(dev, frame, r->x, r->y, r->w, r->h, mode);
+            continue;
+        }
+
+        // Mirror into the shadow while the transfers drain
+        if (dev->shadow && frame != dev->shadow) {
+            for (int l = 0; l < r->h; l++) {
+                memcpy(dev->shadow + (size_t)(r->y + l) * stride + r->x,
+                       frame + (size_t)(r->y + l) * stride + r->x, r->w);
+            }
+        }
+    }
+
+    while (inflight > 0) {
+        ret |= batch_reap(dev);
+        inflight--;
+    }
+    dev->stats.load_ns += now_ns() - t0;
+
+    // All pixel data has landed: fire the refreshes. Rects from sync_from
+    // on were already displayed by the send_rect() fallback.
+    for (int i = 0; i < sync_from; i++) {
+        ret |= display_area(dev, dev->img_addr, dev->batch[i].x, dev->batch[i].y,
+                            dev->batch[i].w, dev->batch[i].h, mode);
+    }
+    return ret;
+}
+
+int it8951_set_dither(IT8951_USB *dev, int mode) {
+    if (mode != IT8951_DITHER_NONE && mode != IT8951_DITHER_ORDERED &&
+        mode != IT8951_DITHER_FS) {
+        return -1;
+    }
+    dev->dither = mode;
+    return 0;
+}
+
+void it8951_set_refresh_policy(IT8951_USB *dev, const IT8951_refresh_policy *p) {
+    if (p) {
+        dev->policy = *p;
+    } else {
+        dev->policy = (IT8951_refresh_policy){ .max_a2_updates = 8,
+                                               .idle_ms = 300,
+                                               .tiles_per_pass = 4 };
+    }
+}
+
+int it8951_maintain(IT8951_USB *dev) {
+    // Only reconcile from the retained framebuffer, and only once the
+    // panel has been quiet for the configured idle window
+    if (!dev->shadow || !dev->shadow_valid) return 0;
+    if (dev->last_update_ns == 0) return 0;
+    if (now_ns() - dev->last_update_ns < (uint64_t)dev->policy.idle_ms * 1000000ull) {
+        return 0;
+    }
+
+    int tw = (dev->width + IT8951_TILE_GRID - 1) / IT8951_TILE_GRID;
+    int th = (dev->height + IT8951_TILE_GRID - 1) / IT8951_TILE_GRID;
+    int done = 0;
+
+    while (done < dev->policy.tiles_per_pass) {
+        // Pick the most-ghosted tile past the policy threshold
+        int worst = -1;
+        uint32_t worst_count = (uint32_t)dev->policy.max_a2_updates;
+        for (int i = 0; i < IT8951_TILE_GRID * IT8951_TILE_GRID; i++) {
+            if (dev->tile_a2[i] >= worst_count) {
+                worst_count = dev->tile_a2[i];
+                worst = i;
+            }
+        }
+        if (worst < 0) break;
+
+        int tx = worst % IT8951_TILE_GRID;
+        int ty = worst / IT8951_TILE_GRID;
+
+        // Tile edges land on width/8 multiples, not the 8-pixel alignment
+        // the controller wants; clip_rect() aligns them like every other
+        // partial-update path
+        IT8951_rect r = { tx * tw, ty * th, tw, th };
+        if (!clip_rect(dev, &r)) break;
+
+        // Redisplaying the shadow with GC16 clears accumulated ghosting;
+        // note_refresh() zeroes the tile counter as a side effect
+        it8951_wait(dev);
+        send_rect(dev, dev->shadow, r.x, r.y, r.w, r.h, MODE_GC16);
+        done++;
+    }
+    return done;
 }
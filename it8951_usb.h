@@ -7,6 +7,8 @@
 #define IT8951_USB_H
 
 #include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 // Display modes
 #define MODE_INIT 0   // Full clear
@@ -14,11 +16,98 @@
 #define MODE_GC16 2   // 16-level grayscale
 #define MODE_A2   4   // Fast 2-level (B&W)
 
+// Not a waveform: asks the driver to pick one from frame content.
+// Essentially-bilevel frames (documents, QR codes) take the fast DU
+// path; frames with real midtones pay for GC16. Accepted anywhere a
+// MODE_* is, resolved per frame.
+#define MODE_AUTO (-1)
+
+// Dither modes for bilevel waveforms (see it8951_set_dither)
+#define IT8951_DITHER_NONE    0  // Let the controller threshold (default)
+#define IT8951_DITHER_ORDERED 1  // 8x8 Bayer, fast, band-parallel
+#define IT8951_DITHER_FS      2  // Floyd-Steinberg, best midtones, serial
+
+// Transfer pixel formats (see it8951_set_pixel_format)
+#define IT8951_FMT_8BPP 0  // 1 byte per pixel (default, always supported)
+#define IT8951_FMT_4BPP 1  // Packed nibbles - halves the USB payload
+#define IT8951_FMT_1BPP 2  // Packed bits - for A2/DU bilevel content
+
+// Rectangle within the panel, in pixels
+typedef struct {
+    int x, y, w, h;
+} IT8951_rect;
+
+// Refresh scheduler policy (see it8951_set_refresh_policy)
+typedef struct {
+    int max_a2_updates;  // A2/DU updates a tile tolerates before reconciliation
+    int idle_ms;         // Quiet time before maintenance may run
+    int tiles_per_pass;  // Max tiles reconciled per it8951_maintain() call
+} IT8951_refresh_policy;
+
+// Ghosting tracker tile grid
+#define IT8951_TILE_GRID 8
+
+// Max rectangles held by a command batch (and by it8951_display_rects)
+#define IT8951_BATCH_MAX 32
+
+// Lightweight always-on transfer counters (see it8951_get_stats).
+// Atomic because the caller's upload thread and the async refresh
+// worker both update them.
+typedef struct {
+    _Atomic uint64_t sgio_calls;   // Total SG_IO ioctls issued
+    _Atomic uint64_t bytes_sent;   // Payload bytes pushed to the device
+    _Atomic uint64_t load_ns;      // Time spent in load-image transfers
+    _Atomic uint64_t display_ns;   // Time spent in display/refresh commands
+    _Atomic uint64_t refreshes;    // display_area commands issued
+    _Atomic uint64_t retries;      // Commands retried after a failed attempt
+    _Atomic uint64_t reopens;      // Device re-open handshakes after a dead handle
+} IT8951_stats;
+
 typedef struct {
     int fd;
+    char devpath[128];      // SG node path, for the recovery re-open
+    pthread_mutex_t recover_lock;
     uint16_t width;
     uint16_t height;
     unsigned int img_addr;  // Image buffer address from device
+    unsigned int upd_addr;  // Update buffer address (second device-side buffer)
+    uint8_t *shadow;        // Last framebuffer sent to the device (diff engine)
+    int shadow_valid;       // 0 until a full frame has been pushed
+    uint8_t *xfer_buf;      // Reusable transfer buffer: area header + pixel payload
+    int use_iovec;          // Zero-copy scatter-gather SG_IO supported by the device
+    int pixel_format;       // IT8951_FMT_* used for image uploads
+    int chunk_size;         // Max payload bytes per load transfer
+    int timeout_ms;         // Per-command SG timeout (tightened by calibrate)
+    int dither;             // IT8951_DITHER_* applied before A2/DU displays
+    uint8_t *dither_buf;    // Scratch frame for the dither stage
+    IT8951_stats stats;
+
+    // Refresh scheduler: per-tile A2/DU update counts since the last
+    // quality (GC16/INIT) pass over that tile
+    uint32_t tile_a2[IT8951_TILE_GRID * IT8951_TILE_GRID];
+    uint64_t last_update_ns;
+    IT8951_refresh_policy policy;
+
+    // Async refresh pipeline: uploads run on the caller's thread against the
+    // idle device buffer while the worker waits out the panel refresh
+    pthread_t refresh_thread;
+    pthread_mutex_t async_lock;
+    pthread_cond_t async_cond;
+    int async_started;      // Worker thread running
+    int async_pending;      // A refresh is queued or in progress
+    int async_quit;
+    unsigned int cur_addr;  // Back buffer: device address the next upload targets
+    unsigned int front_addr; // Front buffer: device address being scanned out
+    unsigned int alloc_next; // Bump allocator cursor for extra device regions
+    unsigned int pending_addr;
+    int pending_x, pending_y, pending_w, pending_h, pending_mode;
+
+    // Command batch (it8951_batch_*)
+    int batching;           // Between batch_begin and batch_submit
+    int batch_count;
+    IT8951_rect batch[IT8951_BATCH_MAX];
+    int use_sg_async;       // sg write()/read() command queueing supported
+    uint8_t *batch_buf;     // Slot buffers for in-flight queued loads
 } IT8951_USB;
 
 // Initialize USB connection to IT8951
@@ -33,4 +122,114 @@ int it8951_clear(IT8951_USB *dev, int mode);
 // Display 8-bit grayscale image
 int it8951_display(IT8951_USB *dev, uint8_t *image, int x, int y, int w, int h, int mode);
 
+// Two-phase display: upload image data without triggering a refresh,
+// then refresh previously uploaded regions. Lets callers overlap or
+// synchronize the phases themselves (multi-panel walls, band streaming).
+int it8951_upload(IT8951_USB *dev, uint8_t *image, int x, int y, int w, int h);
+int it8951_refresh(IT8951_USB *dev, int x, int y, int w, int h, int mode);
+
+// Display a full frame, transferring only the regions that changed since
+// the last frame. Falls back to a full it8951_display() on the first frame.
+int it8951_display_diff(IT8951_USB *dev, uint8_t *image, int mode);
+
+// Animation fast path: full-frame A2 display that only transmits the
+// rows that changed since the last frame, packed to the configured
+// pixel format (set IT8951_FMT_1BPP for 8 pixels per byte - A2 is
+// bilevel anyway). For sprite-scale motion the per-frame payload drops
+// from megabytes to tens of KB.
+int it8951_display_a2(IT8951_USB *dev, uint8_t *image);
+
+// Upload a full frame to the idle device buffer and queue its refresh on a
+// worker thread, overlapping frame N+1's USB upload with frame N's waveform
+// refresh. Returns once the upload is done; the image may then be freed.
+int it8951_display_async(IT8951_USB *dev, uint8_t *image, int mode);
+
+// Block until any queued async refresh has completed
+void it8951_wait(IT8951_USB *dev);
+
+// Select the transfer pixel format for subsequent uploads. GC16 only uses
+// 16 gray levels and A2 two, so 4bpp/1bpp packing halves (or eighths) the
+// per-frame USB payload. Only enable packed formats on controller firmware
+// known to accept them through the load-image command; the default 8bpp
+// works everywhere. Returns 0 on success, -1 for an unknown format.
+int it8951_set_pixel_format(IT8951_USB *dev, int fmt);
+
+// Refresh one region of a full-panel framebuffer (frame is width x height,
+// unlike it8951_display() which takes a tightly packed w x h buffer).
+// The rectangle is clipped to panel bounds and aligned for the controller.
+int it8951_display_region(IT8951_USB *dev, uint8_t *frame,
+                          int x, int y, int w, int h, int mode);
+
+// Refresh several regions of a full-panel framebuffer in one call.
+// Overlapping or near-adjacent rectangles are coalesced first so small
+// overlay widgets don't pay one transfer + refresh each.
+int it8951_display_rects(IT8951_USB *dev, uint8_t *frame,
+                         const IT8951_rect *rects, int n, int mode);
+
+// Batched multi-rectangle submission. Queue dirty rectangles between
+// begin and submit; submit coalesces them, then pushes every load chunk
+// through the sg driver's queued write()/read() interface - a window of
+// transfers is in flight at once, so a frame's worth of chunks costs a
+// few reap syscalls instead of one blocking SG_IO ioctl each. The
+// refreshes follow once all pixel data has landed. Falls back to the
+// synchronous path if the sg driver rejects queued writes. frame is a
+// full-panel framebuffer as in it8951_display_region().
+int it8951_batch_begin(IT8951_USB *dev);
+int it8951_batch_add_rect(IT8951_USB *dev, int x, int y, int w, int h);
+int it8951_batch_submit(IT8951_USB *dev, uint8_t *frame, int mode);
+
+// Snapshot / reset the driver's transfer counters
+void it8951_get_stats(IT8951_USB *dev, IT8951_stats *out);
+void it8951_reset_stats(IT8951_USB *dev);
+
+// Cap the payload size of each load transfer (clamped to sane bounds).
+// Mainly for the benchmark suite and per-host tuning.
+void it8951_set_chunk_size(IT8951_USB *dev, int bytes);
+
+// One probed point from the transfer autotuner
+typedef struct {
+    int chunk_size;
+    double mb_per_s;
+} IT8951_tune_point;
+
+// Probe a few chunk sizes with timed uploads to the idle device buffer,
+// adopt the fastest for the chunk loops, and derive the per-command
+// timeout from the measured throughput. The fleet spans Pi Zero behind
+// a hub to Pi 5, and the ioctl-cost / pipelining sweet spot differs.
+// Fills up to max_points probe results into out (may be NULL; unused
+// entries get chunk_size 0). Returns the adopted chunk size, -1 on
+// probe failure.
+int it8951_calibrate(IT8951_USB *dev, IT8951_tune_point *out, int max_points);
+
+// Configure the dither stage applied to frames displayed with MODE_A2 or
+// MODE_DU. Raw 8-bit input thresholded by the controller destroys
+// midtones; dithering first makes the fast modes usable for photos.
+// Returns 0 on success, -1 for an unknown mode.
+int it8951_set_dither(IT8951_USB *dev, int mode);
+
+// Device-side buffer management. The controller exposes two frame
+// buffers (image + update address); uploads target the back buffer while
+// the panel scans out the front, and flipping swaps the roles. The async
+// display path drives this automatically; these are for callers doing
+// their own upload/refresh sequencing with it8951_upload()/it8951_refresh().
+unsigned int it8951_buffer_back(IT8951_USB *dev);
+unsigned int it8951_buffer_front(IT8951_USB *dev);
+void it8951_buffer_flip(IT8951_USB *dev);
+
+// Reserve a region of device RAM beyond the two frame buffers (e.g. for
+// preloaded assets). Returns the device address, or 0 when out of the
+// window the driver is willing to hand out. Bump allocation only - there
+// is no free.
+unsigned int it8951_alloc_region(IT8951_USB *dev, int bytes);
+
+// Override the refresh scheduler policy (pass NULL to restore defaults)
+void it8951_set_refresh_policy(IT8951_USB *dev, const IT8951_refresh_policy *p);
+
+// Call from the idle loop. After the configured quiet period this picks
+// the most-ghosted tiles (those past max_a2_updates fast refreshes) and
+// redisplays their shadow content with GC16, bounding quality decay
+// without ever dropping out of the fast A2 path while busy.
+// Returns the number of tiles reconciled (0 when busy or clean).
+int it8951_maintain(IT8951_USB *dev);
+
 #endif
@@ -0,0 +1,217 @@
+/**
+ * Network display mode - see netrecv.h
+ */
+
+#include "netrecv.h"
+#include "imgproc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define MAX_PAYLOAD (32 * 1024 * 1024)
+
+// Latest-frame mailbox: the receiver fills one buffer, publishes it as
+// "ready" (replacing any frame the display loop hasn't taken yet), and
+// keeps filling into whatever buffer rotated out. Three buffers mean
+// neither side ever waits for the other's memory.
+typedef struct {
+    int port;
+    int w, h;
+    uint8_t *buf[3];
+    int mode[3];
+    int fill, ready, show;
+    int has_ready;
+    uint64_t received, dropped;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} NetState;
+
+// Read exactly len bytes; 0 on success, -1 on EOF/error
+static int read_full(int fd, void *buf, size_t len) {
+    uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Publish the fill buffer as the latest frame, dropping a stale one
+static void publish(NetState *st, int mode) {
+    pthread_mutex_lock(&st->lock);
+    int tmp = st->ready;
+    st->ready = st->fill;
+    st->fill = tmp;
+    st->mode[st->ready] = mode;
+    if (st->has_ready) st->dropped++;
+    st->has_ready = 1;
+    st->received++;
+    pthread_cond_broadcast(&st->cond);
+    pthread_mutex_unlock(&st->lock);
+}
+
+// Serve one sender until it disconnects
+static void serve_conn(NetState *st, int fd) {
+    uint8_t *payload = NULL;
+    size_t payload_cap = 0;
+
+    while (1) {
+        EinkNetFrame hdr;
+        if (read_full(fd, &hdr, sizeof(hdr)) < 0) break;
+
+        uint32_t format = ntohl(hdr.format);
+        uint32_t fw = ntohl(hdr.width);
+        uint32_t fh = ntohl(hdr.height);
+        uint32_t mode = ntohl(hdr.mode);
+        uint32_t length = ntohl(hdr.length);
+
+        if (ntohl(hdr.magic) != EINK_NET_MAGIC ||
+            length == 0 || length > MAX_PAYLOAD) {
+            fprintf(stderr, "net: bad frame header, dropping connection\n");
+            break;
+        }
+
+        // Panel-sized raw frames land straight in the mailbox buffer;
+        // everything else goes through a scratch payload first
+        if (format == EINK_NET_RAW8 && fw == (uint32_t)st->w &&
+            fh == (uint32_t)st->h && length == (uint32_t)(st->w * st->h)) {
+            if (read_full(fd, st->buf[st->fill], length) < 0) break;
+            publish(st, (int)mode);
+            continue;
+        }
+
+        if (length > payload_cap) {
+            uint8_t *grown = realloc(payload, length);
+            if (!grown) break;
+            payload = grown;
+            payload_cap = length;
+        }
+        if (read_full(fd, payload, length) < 0) break;
+
+        if (format == EINK_NET_RAW8) {
+            if (fw == 0 || fh == 0 || (uint64_t)fw * fh != length) continue;
+            imgproc_resize_bilinear(payload, (int)fw, (int)fh,
+                                    st->buf[st->fill], st->w, st->h);
+            publish(st, (int)mode);
+        } else if (format == EINK_NET_JPEG) {
+            uint8_t *decoded = imgproc_decode_jpeg_gray(payload, length,
+                                                        st->w, st->h);
+            if (!decoded) continue;  // Corrupt frame: skip, keep the stream
+            memcpy(st->buf[st->fill], decoded, (size_t)st->w * st->h);
+            free(decoded);
+            publish(st, (int)mode);
+        }
+        // Unknown formats are skipped (payload already consumed)
+    }
+    free(payload);
+    close(fd);
+}
+
+// Receiver thread: accept senders one at a time, fill the mailbox
+static void *recv_thread(void *arg) {
+    NetState *st = arg;
+    int port = st->port;
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) return NULL;
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listener, 1) < 0) {
+        perror("net: listen");
+        close(listener);
+        return NULL;
+    }
+    printf("Listening on port %d (raw gray8 / JPEG frames)\n", port);
+
+    while (1) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // Frames are latency-sensitive; don't let Nagle batch the acks
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        printf("net: sender connected\n");
+        serve_conn(st, fd);
+        printf("net: sender disconnected\n");
+    }
+    close(listener);
+    return NULL;
+}
+
+int eink_net_run(IT8951_USB *dev, int port) {
+    if (port <= 0) port = EINK_NET_PORT;
+
+    NetState st;
+    memset(&st, 0, sizeof(st));
+    st.w = dev->width;
+    st.h = dev->height;
+    st.fill = 0;
+    st.ready = 1;
+    st.show = 2;
+    pthread_mutex_init(&st.lock, NULL);
+    pthread_cond_init(&st.cond, NULL);
+
+    for (int i = 0; i < 3; i++) {
+        st.buf[i] = malloc((size_t)st.w * st.h);
+        if (!st.buf[i]) {
+            while (i-- > 0) free(st.buf[i]);
+            return -1;
+        }
+    }
+
+    st.port = port;
+    pthread_t rx;
+    if (pthread_create(&rx, NULL, recv_thread, &st) != 0) {
+        for (int i = 0; i < 3; i++) free(st.buf[i]);
+        return -1;
+    }
+
+    it8951_clear(dev, MODE_INIT);
+
+    // Display loop: take the latest frame, let the dirty-rect engine
+    // decide how much actually hits the bus
+    uint64_t shown = 0;
+    while (1) {
+        pthread_mutex_lock(&st.lock);
+        while (!st.has_ready) {
+            pthread_cond_wait(&st.cond, &st.lock);
+        }
+        int tmp = st.show;
+        st.show = st.ready;
+        st.ready = tmp;
+        st.has_ready = 0;
+        uint64_t dropped = st.dropped;
+        pthread_mutex_unlock(&st.lock);
+
+        it8951_display_diff(dev, st.buf[st.show], st.mode[st.show]);
+        shown++;
+
+        if (shown % 50 == 0) {
+            printf("net: %llu shown, %llu dropped\n",
+                   (unsigned long long)shown, (unsigned long long)dropped);
+        }
+    }
+
+    return 0;
+}
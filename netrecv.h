@@ -0,0 +1,44 @@
+/**
+ * Network display mode - frames rendered elsewhere, scanned out here
+ *
+ * A Pi Zero can't afford heavy image processing, so a server renders
+ * frames and streams them over TCP; this side only decodes (JPEG) or
+ * copies (raw gray8) and drives the panel. A latest-frame mailbox sits
+ * between the receiver and the display loop: while a slow e-ink refresh
+ * is in progress, newer frames replace each other instead of queueing,
+ * so display latency stays USB + waveform bound.
+ */
+
+#ifndef NETRECV_H
+#define NETRECV_H
+
+#include "it8951_usb.h"
+#include <stddef.h>
+
+#define EINK_NET_PORT 8951
+
+// Payload formats
+#define EINK_NET_RAW8 0  // width x height bytes, 8-bit grayscale
+#define EINK_NET_JPEG 1  // JPEG stream, decoded with libjpeg locally
+
+// Per-frame header, all fields big-endian (network order).
+// A raw payload of panel size is copied straight into the mailbox;
+// other sizes (and JPEG output) are bilinear-resized to the panel.
+typedef struct {
+    uint32_t magic;   // 'E8NF'
+    uint32_t format;  // EINK_NET_RAW8 / EINK_NET_JPEG
+    uint32_t width;   // Raw payload dimensions (ignored for JPEG)
+    uint32_t height;
+    uint32_t mode;    // MODE_* waveform for this frame
+    uint32_t length;  // Payload bytes that follow
+} EinkNetFrame;
+
+#define EINK_NET_MAGIC 0x45384e46
+
+// Listen on port (0 = EINK_NET_PORT) and display received frames until
+// the process is signalled. One sender at a time; a new connection is
+// accepted when the current one closes. Returns -1 if the listener
+// could not be created.
+int eink_net_run(IT8951_USB *dev, int port);
+
+#endif
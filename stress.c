@@ -0,0 +1,223 @@
+/**
+ * Endurance / torture test for panel and driver qualification
+ *
+ * Cycles scripted phases for a configurable number of minutes:
+ * full-frame GC16 refreshes, dirty-rect storms of random small
+ * rectangles, and sustained A2 streaming of synthetic sprite frames -
+ * no camera required. Every reporting interval it appends a CSV row
+ * with latency percentiles, error counts, driver transfer stats, SoC
+ * temperature and a throttling marker, so latency regressions and
+ * flaky-USB units show up before the fleet rollout, not after.
+ *
+ * Build: make stress
+ * Run:   sudo ./stress /dev/sdX [minutes] [out.csv]
+ */
+
+#include "it8951_usb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_MINUTES 60
+#define REPORT_INTERVAL_S 30
+#define MAX_SAMPLES 4096
+#define PHASE_SECONDS 60
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double d = *(const double *)a - *(const double *)b;
+    return (d > 0) - (d < 0);
+}
+
+static double percentile(double *sorted, int n, double p) {
+    int idx = (int)(p * (n - 1) + 0.5);
+    return sorted[idx];
+}
+
+// Read one integer from a sysfs file; -1 if unavailable
+static long read_sysfs_long(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    long v = -1;
+    if (fscanf(f, "%ld", &v) != 1) v = -1;
+    fclose(f);
+    return v;
+}
+
+// SoC temperature in degrees C (thermal_zone0 is the SoC on every Pi)
+static double soc_temp(void) {
+    long mdeg = read_sysfs_long("/sys/class/thermal/thermal_zone0/temp");
+    return mdeg < 0 ? -1.0 : mdeg / 1000.0;
+}
+
+// Throttling marker: the governor pulls the clock under its maximum
+static int throttled(void) {
+    long cur = read_sysfs_long(
+        "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+    long max = read_sysfs_long(
+        "/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    if (cur < 0 || max < 0) return 0;
+    return cur < max - max / 20;  // >5% under max counts as throttled
+}
+
+// Gradient test pattern: exercises all gray levels
+static void fill_gradient(uint8_t *buf, int w, int h, int phase) {
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            buf[(size_t)y * w + x] = (uint8_t)((x + y + phase) & 0xFF);
+        }
+    }
+}
+
+// Synthetic A2 frame: white field with a few black blocks orbiting, the
+// same sprite-scale motion the runner demo produces
+static void fill_sprites(uint8_t *buf, int w, int h, int tick) {
+    memset(buf, 0xFF, (size_t)w * h);
+    for (int s = 0; s < 4; s++) {
+        int size = 96 + s * 32;
+        int x = (tick * (7 + s * 3) + s * w / 4) % (w - size);
+        int y = (tick * (5 + s * 2) + s * h / 4) % (h - size);
+        for (int row = y; row < y + size; row++) {
+            memset(buf + (size_t)row * w + x, 0x00, size);
+        }
+    }
+}
+
+// Accumulates one reporting interval's worth of per-op latencies
+typedef struct {
+    double samples[MAX_SAMPLES];
+    int n;
+    int errors;
+} Interval;
+
+static void interval_add(Interval *iv, double ms, int err) {
+    if (iv->n < MAX_SAMPLES) iv->samples[iv->n++] = ms;
+    if (err) iv->errors++;
+}
+
+// Flush one CSV row of aggregates and reset the interval
+static void interval_flush(Interval *iv, FILE *csv, double elapsed_s,
+                           const char *phase, IT8951_USB *dev) {
+    if (iv->n == 0) return;
+    qsort(iv->samples, iv->n, sizeof(double), cmp_double);
+
+    IT8951_stats st;
+    it8951_get_stats(dev, &st);
+
+    double p50 = percentile(iv->samples, iv->n, 0.50);
+    double p90 = percentile(iv->samples, iv->n, 0.90);
+    double p99 = percentile(iv->samples, iv->n, 0.99);
+    double max = iv->samples[iv->n - 1];
+
+    fprintf(csv, "%.0f,%s,%d,%.1f,%.1f,%.1f,%.1f,%d,%llu,%llu,%.1f,%d\n",
+            elapsed_s, phase, iv->n, p50, p90, p99, max, iv->errors,
+            (unsigned long long)st.sgio_calls,
+            (unsigned long long)st.bytes_sent,
+            soc_temp(), throttled());
+    fflush(csv);
+
+    printf("[%6.0fs] %-10s %4d ops  p50=%6.1f p99=%6.1f max=%6.1f ms  "
+           "err=%d  %.1fC%s\n",
+           elapsed_s, phase, iv->n, p50, p99, max, iv->errors,
+           soc_temp(), throttled() ? " THROTTLED" : "");
+
+    iv->n = 0;
+    iv->errors = 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("Usage: sudo %s /dev/sdX [minutes] [out.csv]\n", argv[0]);
+        return 1;
+    }
+    int minutes = (argc > 2) ? atoi(argv[2]) : DEFAULT_MINUTES;
+    if (minutes < 1) minutes = DEFAULT_MINUTES;
+    const char *csv_path = (argc > 3) ? argv[3] : "stress.csv";
+
+    IT8951_USB *dev = it8951_usb_open(argv[1]);
+    if (!dev) return 1;
+
+    int w = dev->width, h = dev->height;
+    uint8_t *frame = malloc((size_t)w * h);
+    Interval *iv = calloc(1, sizeof(Interval));
+    FILE *csv = fopen(csv_path, "w");
+    if (!frame || !iv || !csv) {
+        printf("Out of memory or cannot write %s\n", csv_path);
+        it8951_usb_close(dev);
+        return 1;
+    }
+    fprintf(csv, "elapsed_s,phase,ops,p50_ms,p90_ms,p99_ms,max_ms,"
+                 "errors,sgio_calls,bytes_sent,soc_temp_c,throttled\n");
+
+    printf("Torture test: %d min on %dx%d, CSV -> %s\n",
+           minutes, w, h, csv_path);
+    it8951_clear(dev, MODE_INIT);
+    it8951_reset_stats(dev);
+    srand(1);  // Deterministic storms: comparable runs across units
+
+    double start = now_ms();
+    double end = start + minutes * 60000.0;
+    double next_report = start + REPORT_INTERVAL_S * 1000.0;
+    int tick = 0;
+
+    while (now_ms() < end) {
+        // Phases rotate each PHASE_SECONDS of elapsed time
+        int phase = ((int)((now_ms() - start) / 1000.0) / PHASE_SECONDS) % 3;
+        const char *phase_name =
+            phase == 0 ? "gc16" : phase == 1 ? "rects" : "a2";
+        double t0;
+        int err;
+
+        if (phase == 0) {
+            // Full-frame quality refreshes: worst-case load + waveform
+            fill_gradient(frame, w, h, tick * 37);
+            t0 = now_ms();
+            err = it8951_display(dev, frame, 0, 0, w, h, MODE_GC16);
+        } else if (phase == 1) {
+            // Dirty-rect storm: a burst of random small rectangles, the
+            // UI-overlay pattern that stresses coalescing and per-op cost
+            IT8951_rect rects[8];
+            for (int i = 0; i < 8; i++) {
+                rects[i].w = 64 + rand() % 256;
+                rects[i].h = 64 + rand() % 256;
+                rects[i].x = rand() % (w - rects[i].w);
+                rects[i].y = rand() % (h - rects[i].h);
+            }
+            fill_gradient(frame, w, h, tick * 11);
+            t0 = now_ms();
+            err = it8951_display_rects(dev, frame, rects, 8, MODE_DU);
+        } else {
+            // Sustained A2 animation from synthetic sprite frames
+            fill_sprites(frame, w, h, tick);
+            t0 = now_ms();
+            err = it8951_display_a2(dev, frame);
+        }
+
+        interval_add(iv, now_ms() - t0, err != 0);
+        tick++;
+
+        if (now_ms() >= next_report) {
+            interval_flush(iv, csv, (now_ms() - start) / 1000.0,
+                           phase_name, dev);
+            next_report += REPORT_INTERVAL_S * 1000.0;
+        }
+    }
+    interval_flush(iv, csv, (now_ms() - start) / 1000.0, "final", dev);
+
+    IT8951_stats st;
+    it8951_get_stats(dev, &st);
+    printf("\nDone: %d ops total, %llu SG_IO calls, %.1f MB sent\n",
+           tick, (unsigned long long)st.sgio_calls, st.bytes_sent / 1e6);
+
+    fclose(csv);
+    free(frame);
+    free(iv);
+    it8951_usb_close(dev);
+    return 0;
+}
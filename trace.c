@@ -0,0 +1,100 @@
+/**
+ * Latency tracer - see trace.h
+ *
+ * Recording is a relaxed fetch-add on the ring cursor plus four stores;
+ * no locks, safe from any thread. The dump walks whatever is in the
+ * ring at that moment - events recorded during the walk may be torn,
+ * which is acceptable for a debug facility and keeps the hot path free
+ * of synchronization.
+ */
+
+#include "trace.h"
+#include <stdio.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+typedef struct {
+    uint64_t ns;
+    const char *name;
+    uint32_t tid;
+    char phase;       // 'B'egin, 'E'nd, 'i'nstant (Chrome trace phases)
+} TraceEvent;
+
+static TraceEvent ring[TRACE_CAPACITY];
+static _Atomic uint64_t cursor;
+static volatile sig_atomic_t dump_requested;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint32_t my_tid(void) {
+    static __thread uint32_t tid;
+    if (!tid) tid = (uint32_t)syscall(SYS_gettid);
+    return tid;
+}
+
+static void record(const char *name, char phase) {
+    uint64_t i = atomic_fetch_add_explicit(&cursor, 1, memory_order_relaxed);
+    TraceEvent *e = &ring[i & (TRACE_CAPACITY - 1)];
+    e->ns = now_ns();
+    e->name = name;
+    e->tid = my_tid();
+    e->phase = phase;
+}
+
+void trace_begin(const char *name) { record(name, 'B'); }
+void trace_end(const char *name)   { record(name, 'E'); }
+void trace_mark(const char *name)  { record(name, 'i'); }
+
+int trace_dump(const char *path) {
+    uint64_t head = atomic_load_explicit(&cursor, memory_order_acquire);
+    uint64_t start = (head > TRACE_CAPACITY) ? head - TRACE_CAPACITY : 0;
+
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    int first = 1;
+    for (uint64_t i = start; i < head; i++) {
+        TraceEvent e = ring[i & (TRACE_CAPACITY - 1)];
+        if (!e.name) continue;  // Slot not yet written on the first lap
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                   "\"pid\":1,\"tid\":%u%s}",
+                first ? "" : ",\n", e.name, e.phase, e.ns / 1000.0, e.tid,
+                e.phase == 'i' ? ",\"s\":\"t\"" : "");
+        first = 0;
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return 0;
+}
+
+static void on_sigusr1(int sig) {
+    (void)sig;
+    dump_requested = 1;  // File IO happens in trace_poll(), not here
+}
+
+void trace_install_signal(void) {
+    struct sigaction sa;
+    sa.sa_handler = on_sigusr1;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+}
+
+int trace_poll(void) {
+    if (!dump_requested) return 0;
+    dump_requested = 0;
+    if (trace_dump(TRACE_DUMP_PATH) == 0) {
+        printf("Trace dumped to %s\n", TRACE_DUMP_PATH);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * Latency tracer - timestamped stage events in a lock-free ring
+ *
+ * Instruments the capture-to-display path (capture, decode, per-chunk
+ * USB upload, display trigger, refresh wait) at a cost of one
+ * clock_gettime and a few stores per event, always on. The ring keeps
+ * the most recent events; dump it on demand as Chrome trace-format
+ * JSON (load in chrome://tracing or Perfetto) to see where a slow
+ * field unit actually spends its time.
+ *
+ * Trigger a dump with the 't' key in the camera app or by sending
+ * SIGUSR1 to any binary that calls trace_poll() from its loop.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// Events kept (power of two); older entries are overwritten
+#define TRACE_CAPACITY 4096
+
+// Default dump path when triggered by signal/keypress
+#define TRACE_DUMP_PATH "/tmp/eink-trace.json"
+
+// Record the start / end of a named stage on the calling thread.
+// name must be a string literal (the pointer is stored, not the text).
+void trace_begin(const char *name);
+void trace_end(const char *name);
+
+// Mark an instant event (no duration)
+void trace_mark(const char *name);
+
+// Write the ring as Chrome trace-format JSON. Returns 0 on success.
+int trace_dump(const char *path);
+
+// Install the SIGUSR1 handler that requests a dump
+void trace_install_signal(void);
+
+// Call from a main loop: dumps to TRACE_DUMP_PATH if a signal-requested
+// dump is pending. Returns 1 if a dump was written.
+int trace_poll(void);
+
+#endif
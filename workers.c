@@ -0,0 +1,177 @@
+/**
+ * Worker pool for tiled pixel kernels
+ *
+ * One pool for the whole process: conversion, packing, diff and dither
+ * kernels all submit band jobs here instead of spinning up threads. Bands
+ * are claimed from a shared counter so an early-finishing core steals the
+ * remaining work.
+ */
+
+#include "workers.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define WORKERS_MAX 16
+#define WORKERS_MAX_BANDS 256
+
+static struct {
+    pthread_t threads[WORKERS_MAX];
+    int nthreads;
+    int running;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;   // New job posted
+    pthread_cond_t done_cond;   // A band finished
+
+    // Current job
+    unsigned int job_seq;       // Bumped per job so workers detect new work
+    workers_band_fn fn;
+    void *ctx;
+    int total_rows;
+    int band_rows;
+    int nbands;
+    int next_band;              // Next band to claim
+    char band_done[WORKERS_MAX_BANDS];
+    int quit;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void run_band(int band) {
+    int y0 = band * pool.band_rows;
+    int rows = pool.band_rows;
+    if (y0 + rows > pool.total_rows) rows = pool.total_rows - y0;
+    pool.fn(y0, rows, pool.ctx);
+}
+
+static void *worker_main(void *arg) {
+    (void)arg;
+    unsigned int seen_seq = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    while (1) {
+        while (!pool.quit && (pool.job_seq == seen_seq || pool.next_band >= pool.nbands)) {
+            if (pool.job_seq != seen_seq && pool.next_band >= pool.nbands) {
+                seen_seq = pool.job_seq;  // Job already fully claimed
+            }
+            pthread_cond_wait(&pool.work_cond, &pool.lock);
+        }
+        if (pool.quit) break;
+
+        seen_seq = pool.job_seq;
+        while (pool.next_band < pool.nbands) {
+            int band = pool.next_band++;
+            pthread_mutex_unlock(&pool.lock);
+            run_band(band);
+            pthread_mutex_lock(&pool.lock);
+            pool.band_done[band] = 1;
+            pthread_cond_broadcast(&pool.done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+int workers_init(int nthreads) {
+    if (pool.running) return pool.nthreads;
+
+    if (nthreads <= 0) {
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (nthreads > WORKERS_MAX) nthreads = WORKERS_MAX;
+    if (nthreads < 1) nthreads = 1;
+
+    pool.nthreads = 0;
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&pool.threads[i], NULL, worker_main, NULL) != 0) {
+            break;
+        }
+        pool.nthreads++;
+    }
+    pool.running = (pool.nthreads > 0);
+    return pool.nthreads;
+}
+
+int workers_count(void) {
+    return pool.nthreads;
+}
+
+// One job in the pool at a time: the job state is a single shared set,
+// and submitters can race (the net receiver's resize against the display
+// thread's dither). Serializing here costs nothing next to the kernels.
+static pthread_mutex_t submit_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void workers_run(workers_band_fn fn, int total_rows, int band_rows, void *ctx,
+                 workers_band_fn band_done, void *done_ctx) {
+    if (band_rows <= 0) band_rows = total_rows;
+    int nbands = (total_rows + band_rows - 1) / band_rows;
+
+    // Serial path: no pool, single band, or more bands than we track
+    if (!pool.running || nbands <= 1 || nbands > WORKERS_MAX_BANDS) {
+        for (int b = 0; b < nbands; b++) {
+            int y0 = b * band_rows;
+            int rows = band_rows;
+            if (y0 + rows > total_rows) rows = total_rows - y0;
+            fn(y0, rows, ctx);
+            if (band_done) band_done(y0, rows, done_ctx);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&submit_lock);
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.total_rows = total_rows;
+    pool.band_rows = band_rows;
+    pool.nbands = nbands;
+    pool.next_band = 0;
+    memset(pool.band_done, 0, nbands);
+    pool.job_seq++;
+    pthread_cond_broadcast(&pool.work_cond);
+
+    // Hand completed bands downstream in order while the pool works
+    for (int b = 0; b < nbands; b++) {
+        while (!pool.band_done[b]) {
+            // Help out instead of just waiting
+            if (pool.next_band < pool.nbands) {
+                int band = pool.next_band++;
+                pthread_mutex_unlock(&pool.lock);
+                run_band(band);
+                pthread_mutex_lock(&pool.lock);
+                pool.band_done[band] = 1;
+                pthread_cond_broadcast(&pool.done_cond);
+            } else {
+                pthread_cond_wait(&pool.done_cond, &pool.lock);
+            }
+        }
+        if (band_done) {
+            int y0 = b * band_rows;
+            int rows = band_rows;
+            if (y0 + rows > total_rows) rows = total_rows - y0;
+            pthread_mutex_unlock(&pool.lock);
+            band_done(y0, rows, done_ctx);
+            pthread_mutex_lock(&pool.lock);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&submit_lock);
+}
+
+void workers_shutdown(void) {
+    if (!pool.running) return;
+    pthread_mutex_lock(&pool.lock);
+    pool.quit = 1;
+    pthread_cond_broadcast(&pool.work_cond);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < pool.nthreads; i++) {
+        pthread_join(pool.threads[i], NULL);
+    }
+    pool.nthreads = 0;
+    pool.running = 0;
+    pool.quit = 0;
+}
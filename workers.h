@@ -0,0 +1,29 @@
+/**
+ * Worker pool for tiled pixel kernels
+ * Splits full frames into horizontal bands and runs a kernel across cores
+ */
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+// Kernel invoked per band: rows [y0, y0+rows)
+typedef void (*workers_band_fn)(int y0, int rows, void *ctx);
+
+// Start the pool. nthreads = 0 picks one thread per online core.
+// Returns the number of worker threads started (0 = pool unavailable,
+// workers_run() then executes serially on the caller's thread).
+int workers_init(int nthreads);
+
+// Number of threads in the pool (0 if not initialized)
+int workers_count(void);
+
+// Run fn over total_rows split into bands of band_rows. If band_done is
+// non-NULL it is called from the submitting thread, in band order, as
+// each band completes - so finished bands can be handed to the USB
+// uploader while later bands are still being prepared.
+void workers_run(workers_band_fn fn, int total_rows, int band_rows, void *ctx,
+                 workers_band_fn band_done, void *done_ctx);
+
+void workers_shutdown(void);
+
+#endif